@@ -4,14 +4,24 @@
     read, sort, and list courses.
 */
 
+// Needed for open(), close(), mmap() and pthreads with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 #include "catalog.h"
 #include "input.h"
+#include "stats.h"
 
 Catalog *makeCatalog() 
 {
@@ -21,157 +31,1088 @@ Catalog *makeCatalog()
     catalog-> capacity = STARTING_CAPACITY;
     // Resizable array of pointer to keep track of courses.
     catalog-> list = (Course **) malloc(catalog->capacity * sizeof(Course*));
+    // The first block of courses is made when the first course is read.
+    catalog-> blocks = NULL;
+    // Hash index of course ids, every slot starts out empty.
+    catalog-> indexCapacity = INDEX_CAPACITY;
+    catalog-> index = (Course **) calloc(catalog->indexCapacity, sizeof(Course*));
+    // The sorted views are built once all the courses are read.
+    catalog-> byId = NULL;
+    catalog-> byName = NULL;
+    catalog-> deptStart = NULL;
+    catalog-> bySlot = NULL;
+    catalog-> gramStart = NULL;
+    catalog-> byGram = NULL;
 
     return catalog;
 }
 
-void freeCatalog(Catalog *catalog) 
+/** Helper method to let go of a chain of course blocks. Blocks are freed from the newest
+    one back until reaching a block that something else still points at.
+    @param *block pointer to the newest block in the chain.
+*/
+static void freeBlocks(CourseBlock *block) 
 {
-    // Free the courses in catalog list.
-    for (int i = 0; i < catalog->count; i++) {
-        free(catalog->list[i]);
+    while (block != NULL && __atomic_sub_fetch(&block->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        CourseBlock *next = block->next;
+        if (block->mapping != NULL) {
+            munmap(block->mapping, block->mappingSize);
+        }
+        free(block);
+        block = next;
     }
-    // Free the pointer to list.
+}
+
+void freeCatalog(Catalog *catalog) 
+{
+    // Let go of the blocks holding the courses, which frees every course at once unless
+    // a copy of the catalog still shares them.
+    freeBlocks(catalog->blocks);
+    // Free the pointer to list and the hash index.
     free(catalog->list);
+    free(catalog->index);
+    // Free the sorted views and bucket indexes.
+    free(catalog->byId);
+    free(catalog->byName);
+    free(catalog->deptStart);
+    free(catalog->bySlot);
+    free(catalog->gramStart);
+    free(catalog->byGram);
     // Free the catalog.
     free(catalog);
 }
 
+/** Helper method to copy an array.
+    @param *array pointer to the array, or NULL.
+    @param size the number of bytes in the array.
+    @return a pointer to the new copy, or NULL if there was no array.
+*/
+static void *copyArray(void const *array, size_t size) 
+{
+    if (array == NULL) {
+        return NULL;
+    }
+    void *copy = malloc(size);
+    memcpy(copy, array, size);
+    return copy;
+}
+
+Catalog *copyCatalog( Catalog const *catalog ) 
+{
+    // Start with the same fields, including the timeslot starts, then give the copy its
+    // own arrays.
+    Catalog *copy = (Catalog *) malloc(sizeof(Catalog));
+    *copy = *catalog;
+    copy->list = copyArray(catalog->list, catalog->capacity * sizeof(Course*));
+    copy->index = copyArray(catalog->index, catalog->indexCapacity * sizeof(Course*));
+    copy->byId = copyArray(catalog->byId, (catalog->count + 1) * sizeof(Course*));
+    copy->byName = copyArray(catalog->byName, (catalog->count + 1) * sizeof(Course*));
+    copy->bySlot = copyArray(catalog->bySlot, (catalog->count + 1) * sizeof(Course*));
+    copy->deptStart = copyArray(catalog->deptStart, (DEPARTMENT_COUNT + 1) * sizeof(int));
+    if (catalog->gramStart != NULL) {
+        copy->gramStart = copyArray(catalog->gramStart, (TRIGRAM_BUCKETS + 1) * sizeof(int));
+        copy->byGram = copyArray(catalog->byGram, (catalog->gramStart[TRIGRAM_BUCKETS] + 1) * sizeof(int));
+    }
+    
+    // The copy points at the same newest block, so it counts as a reference to it.
+    if (copy->blocks != NULL) {
+        __atomic_add_fetch(&copy->blocks->refs, 1, __ATOMIC_RELAXED);
+    }
+    return copy;
+}
+
+void adoptMapping( Catalog *catalog, void *data, size_t size ) 
+{
+    // The mapping goes in a block with no room for courses of its own.
+    CourseBlock *block = (CourseBlock *) malloc(sizeof(CourseBlock));
+    block->next = catalog->blocks;
+    block->refs = 1;
+    block->count = 0;
+    block->capacity = 0;
+    block->mapping = data;
+    block->mappingSize = size;
+    catalog->blocks = block;
+}
+
+size_t catalogSize( Catalog const *catalog ) 
+{
+    // Courses are in blocks, or in the image a block stands for.
+    size_t size = sizeof(Catalog);
+    for (CourseBlock const *block = catalog->blocks; block != NULL; block = block->next) {
+        size += sizeof(CourseBlock) + block->capacity * sizeof(Course) + block->mappingSize;
+    }
+    
+    // The list and the index, then each view that has been built.
+    size += catalog->capacity * sizeof(Course*) + catalog->indexCapacity * sizeof(Course*);
+    if (catalog->byId != NULL) {
+        size += 3 * (catalog->count + 1) * sizeof(Course*) + (DEPARTMENT_COUNT + 1) * sizeof(int);
+    }
+    if (catalog->gramStart != NULL) {
+        size += (TRIGRAM_BUCKETS + 1 + catalog->gramStart[TRIGRAM_BUCKETS] + 1) * sizeof(int);
+    }
+    return size;
+}
+
+/** Helper method to hash a packed course id into a slot of the hash index.
+    @param id the packed course id.
+    @param capacity the number of slots in the index, a power of two.
+    @return the slot where the search for the course id should start.
+*/
+static int hashCourseId(int id, int capacity) 
+{
+    // Multiplicative hash, folding the high bits down so they reach the slot.
+    unsigned int hash = (unsigned int) id * 2654435761u;
+    hash ^= hash >> 16;
+    return hash & (capacity - 1);
+}
+
+/** Helper method to add a course to the hash index. The course must not already be
+    in the index and the index must have at least one empty slot.
+    @param *catalog pointer to the given catalog.
+    @param *course pointer to the course to add.
+*/
+static void indexCourse(Catalog *catalog, Course *course) 
+{
+    // Linear probing until an empty slot is found.
+    int slot = hashCourseId(course->id, catalog->indexCapacity);
+    while (catalog->index[slot] != NULL) {
+        slot = (slot + 1) & (catalog->indexCapacity - 1);
+    }
+    catalog->index[slot] = course;
+}
+
+/** Helper method to double the size of the hash index and rehash every course in it.
+    @param *catalog pointer to the given catalog.
+*/
+static void growIndex(Catalog *catalog) 
+{
+    Course **old = catalog->index;
+    int oldCapacity = catalog->indexCapacity;
+    
+    // Start over with an empty index twice the size.
+    catalog->indexCapacity *= DOUBLE_ARRAY;
+    catalog->index = (Course **) calloc(catalog->indexCapacity, sizeof(Course*));
+    for (int i = 0; i < oldCapacity; i++) {
+        if (old[i] != NULL) {
+            indexCourse(catalog, old[i]);
+        }
+    }
+    free(old);
+}
+
+Course *findCourseById( Catalog const *catalog, int id ) 
+{
+    // Probe from the home slot until the course or an empty slot is found.
+    int slot = hashCourseId(id, catalog->indexCapacity);
+    while (catalog->index[slot] != NULL) {
+        if (catalog->index[slot]->id == id) {
+            return catalog->index[slot];
+        }
+        slot = (slot + 1) & (catalog->indexCapacity - 1);
+    }
+    return NULL;
+}
+
+Course *findCourse( Catalog const *catalog, char const *dept, char const *number ) 
+{
+    // A malformed course id can't be in the catalog.
+    int id = packCourseId(dept, number);
+    if (id < 0) {
+        return NULL;
+    }
+    return findCourseById(catalog, id);
+}
+
 /** Helper method to check for duplicate courses in the course file.
     @param *catalog pointer to the given catalog.
-    @param *idept pointer to a given course department.
-    @param *inumber pointer to a given course number.
+    @param id the packed course id of a given course.
     @return true if there is a duplicate and false otherwise.
 */
-static bool isDuplicate(Catalog *catalog, char *idept, char *inumber) 
+static bool isDuplicate(Catalog *catalog, int id) 
 {
     // Return true if given course id is already in catalog.
-    for (int i = 0; i < catalog->count; i++) {
-        if (strcmp(catalog->list[i]->dept, idept) == 0 && strcmp(catalog->list[i]->number, inumber) == 0) {
-            return true;
+    return findCourseById(catalog, id) != NULL;
+}
+
+/** The 6 valid times, in the order they happen during the day. */
+static char const *validTimes[NUMBER_OF_VALID_TIME] = {"8:30", "10:00", "11:30", "1:00", "2:30", "4:00"};
+
+/** The 2 valid day patterns, in alphabetical order. */
+static char const *validDays[NUMBER_OF_VALID_DAYS] = {"MW", "TH"};
+
+int packDepartment( char const *dept ) 
+{
+    // Treat the three letters as digits of a base 26 number.
+    int packed = 0;
+    for (int i = 0; i < DEPARTMENT_LETTERS; i++) {
+        if (!isupper(dept[i])) {
+            return -1;
         }
+        packed = packed * ('Z' - 'A' + 1) + (dept[i] - 'A');
     }
-    return false;
+    return dept[DEPARTMENT_LETTERS] == '\0' ? packed : -1;
+}
+
+int packCourseId( char const *dept, char const *number ) 
+{
+    int packed = packDepartment(dept);
+    if (packed < 0) {
+        return -1;
+    }
+    // Append the three digits of the number in base 10.
+    for (int i = 0; i < NUMBER_LETTERS; i++) {
+        if (!isdigit(number[i])) {
+            return -1;
+        }
+        packed = packed * 10 + (number[i] - '0');
+    }
+    return number[NUMBER_LETTERS] == '\0' ? packed : -1;
+}
+
+int packTimeslot( char const *days, char const *timeStr ) 
+{
+    // Find the index of the days and the time, then combine them.
+    for (int d = 0; d < NUMBER_OF_VALID_DAYS; d++) {
+        if (strcmp(days, validDays[d]) == 0) {
+            for (int t = 0; t < NUMBER_OF_VALID_TIME; t++) {
+                if (strcmp(timeStr, validTimes[t]) == 0) {
+                    return d * NUMBER_OF_VALID_TIME + t;
+                }
+            }
+        }
+    }
+    return -1;
 }
 
 bool isTimesValid(char *timeStr) 
 {
-    // Valid time array.
-    char times[NUMBER_OF_VALID_TIME][NUMBER_OF_VALID_TIME] = {"8:30", "10:00", "11:30", "1:00", "2:30", "4:00"};
     // Loop through the time array.
     for (int i = 0; i < NUMBER_OF_VALID_TIME; i++) {
         // Return true give time is valid.
-        if (strcmp(timeStr, times[i]) == 0) {
+        if (strcmp(timeStr, validTimes[i]) == 0) {
             return true;
         }
     }
     return false;
 }
 
-void readCourses( char const *filename, Catalog *catalog ) 
+/** The fields of a line in a course file, in the order they show up. */
+enum CourseField { DEPT_FIELD, NUMBER_FIELD, DAYS_FIELD, TIME_FIELD, NAME_FIELD };
+
+/** Helper method to finish a field once the whitespace after it, or the end of the line,
+    is reached. Null terminates the field and checks what can only be checked once the
+    whole field has been read.
+    @param *course pointer to the course being filled in.
+    @param field the field that was just read.
+    @param len the number of characters in the field.
+    @return true if the field is valid and false otherwise.
+*/
+static bool finishField(Course *course, enum CourseField field, int len) 
 {
-    // Open the file to be read.
-    FILE *fp = fopen(filename, "r");
-    
-    // Print to standard error and exit with status of 1 if file can not be open.
-    if (fp == NULL) {
-        fprintf(stderr, "Can't open file: %s\n", filename);
-        exit(1);
+    switch (field) {
+        // Check if department does not have exactly 3 uppercase letters.
+        case DEPT_FIELD:
+            course->dept[len] = '\0';
+            return len == DEPARTMENT_LETTERS;
+        // Check if course number does not have exactly 3 digits.
+        case NUMBER_FIELD:
+            course->number[len] = '\0';
+            return len == NUMBER_LETTERS;
+        // Check if days are not MW or TH.
+        case DAYS_FIELD:
+            course->days[len] = '\0';
+            return strcmp(course->days, "MW") == 0 || strcmp(course->days, "TH") == 0;
+        // Check if time is not valid, which also gives the packed timeslot.
+        case TIME_FIELD:
+            course->time[len] = '\0';
+            course->slot = packTimeslot(course->days, course->time);
+            return course->slot >= 0;
+        // The name is checked as it's copied.
+        default:
+            course->name[len] = '\0';
+            return true;
     }
+}
+
+/** This function copies a field into a row, padded with spaces to width characters.
+    @param *row where the field starts in the row, already filled with spaces.
+    @param *field the field to copy.
+    @param width number of characters the field takes in the row.
+    @param left true if the field is lined up on the left, false for the right.
+*/
+static void putField(char *row, char const *field, int width, bool left) 
+{
+    int len = strlen(field);
+    memcpy(left ? row : row + width - len, field, len);
+}
+
+/** This function formats the course's row for the course lists, the same as printing
+    it with "%3s %3s %-30s %2s %5s\n". Every field fits in its column after validation,
+    so each row has the same length.
+    @param *course pointer to the course.
+*/
+static void formatRow(Course *course) 
+{
+    // Start from a row of spaces and drop each field into its column.
+    char *row = course->row;
+    memset(row, ' ', ROW_LEN);
+    putField(row, course->dept, DEPARTMENT_LETTERS, false);
+    row += DEPARTMENT_LETTERS + 1;
+    putField(row, course->number, NUMBER_LETTERS, false);
+    row += NUMBER_LETTERS + 1;
+    putField(row, course->name, NAME_LETTERS, true);
+    row += NAME_LETTERS + 1;
+    putField(row, course->days, DAYS_LEN - 1, false);
+    row += DAYS_LEN;
+    putField(row, course->time, TIME_LEN - 1, false);
+    row += TIME_LEN - 1;
+    *row = '\n';
+}
+
+/** Helper method to read one course from a line of a course file. The line doesn't need
+    to be null terminated, so it can be parsed right where it is in the file's memory.
+    Each character is looked at once, checked against the field it's part of and
+    copied straight into the course.
+    @param *line pointer to the first character of the line.
+    @param *end pointer just past the last character of the line.
+    @param *course pointer to the course to fill in.
+    @return true if the line is a valid course and false otherwise.
+*/
+static bool parseCourse(char const *line, char const *end, Course *course) 
+{
+    // The field being read and how many characters of it have been copied.
+    enum CourseField field = DEPT_FIELD;
+    int len = 0;
+    // Whether the last character was part of a word.
+    bool inWord = false;
+    // The packed course id, built up one letter or digit at a time.
+    int id = 0;
     
-    // Loop through to read each course in the course file.
-    while (1) {
+    for (char const *pos = line; pos < end; pos++) {
+        char ch = *pos;
         
-        // Create catalog list as a resizable array.
-        if (catalog->count >= catalog->capacity) {
-            catalog->capacity *= DOUBLE_ARRAY;
-            catalog->list = (Course **)realloc(catalog->list, catalog->capacity * sizeof(Course*));
+        // Whitespace ends a word. Every field but the name is a single word.
+        if (isspace(ch)) {
+            if (inWord && field != NAME_FIELD) {
+                if (!finishField(course, field, len)) {
+                    return false;
+                }
+                field++;
+                len = 0;
+            }
+            inWord = false;
+            continue;
         }
         
-        // A pointer the the read line.
-        char *linePointer = readLine(fp);
-        
-        // String array to store each of the field and later compare.
-        char idept[MAX_STRING_LEN];
-        char inumber[MAX_STRING_LEN];
-        char idays[MAX_STRING_LEN];
-        char itime[MAX_STRING_LEN];
-        char iname[MAX_STRING_LEN];
-        
-        // If line pointer is null, close the file and return to caller function/
-        if (linePointer == NULL) {
-            fclose(fp);
-            return;
+        // Names with several words are put back together with one space between words.
+        if (!inWord && field == NAME_FIELD && len > 0) {
+            if (len >= NAME_LETTERS) {
+                return false;
+            }
+            course->name[len++] = ' ';
         }
-        int num;
-        int newNum;
-        
-        // Scan the each course fields from course file into each string array.
-        int fields = sscanf(linePointer, "%s%s%s%s%s%n", idept, inumber, idays, itime, iname, &num);
-        
-        char new[MAX_STRING_LEN];
-        // Concatenate names with several words using sscanf offset.
-        while (sscanf(linePointer+num, "%s%n", new, &newNum) == 1) {
-            strcat(iname, " ");
-            strcat(iname, new);
-            num += newNum;
-        }
-        // Free the pointer to the line.
-        free(linePointer);
+        inWord = true;
         
-        // Check if line is missing one of the expected field.
-        if (fields != FIELDS) {
-            fprintf(stderr, "Invalid course file: %s\n", filename);
-            exit(1);
+        // Check and copy the character into its field.
+        switch (field) {
+            case DEPT_FIELD:
+                if (len >= DEPARTMENT_LETTERS || !isupper(ch)) {
+                    return false;
+                }
+                course->dept[len++] = ch;
+                id = id * ('Z' - 'A' + 1) + (ch - 'A');
+                break;
+            case NUMBER_FIELD:
+                if (len >= NUMBER_LETTERS || !isdigit(ch)) {
+                    return false;
+                }
+                course->number[len++] = ch;
+                id = id * 10 + (ch - '0');
+                break;
+            case DAYS_FIELD:
+                if (len >= DAYS_LEN - 1) {
+                    return false;
+                }
+                course->days[len++] = ch;
+                break;
+            case TIME_FIELD:
+                if (len >= TIME_LEN - 1) {
+                    return false;
+                }
+                course->time[len++] = ch;
+                break;
+            // Check if name is too long.
+            case NAME_FIELD:
+                if (len >= NAME_LETTERS) {
+                    return false;
+                }
+                course->name[len++] = ch;
+                break;
         }
-        
-        // Check if department does not have exactly 3 uppercase letters.
-        if (strlen(idept) != DEPARTMENT_LETTERS || !isupper(idept[0]) || !isupper(idept[1]) || !isupper(idept[2])) {
-            fprintf(stderr, "Invalid course file: %s\n", filename);
-            exit(1);
+    }
+    
+    // Check if line is missing one of the expected field, then finish the last one.
+    if (field != NAME_FIELD || len == 0) {
+        return false;
+    }
+    finishField(course, field, len);
+    course->id = id;
+    formatRow(course);
+    return true;
+}
+
+/** The partial catalog struct holds the courses read from one piece of a course file,
+    before they are merged into the catalog. Reading pieces into partial catalogs lets 
+    loader threads parse several files, or several chunks of a large file, at the same
+    time. A chunk of a mapped file runs from start up to end. If start is NULL the whole
+    file is read from fd instead. Status is LOAD_INVALID if the piece had an invalid 
+    line, in which case the courses are the ones on the lines before it. Nanos holds the
+    time spent on each phase of loading the piece, if statistics are on.
+*/
+typedef struct {
+    int file;
+    char const *start;
+    char const *end;
+    int fd;
+    CourseBlock *blocks;
+    LoadStatus status;
+    long nanos[LOAD_PHASES];
+    
+} PartialCatalog;
+
+/** Helper method to get memory for the next course in a chain of blocks, from the newest
+    block. If that block is full a new block twice its size is started. The course isn't
+    part of the block until the block's count is incremented.
+    A block shared with another catalog is never added to, so a new block is started then
+    too. The new block takes over the chain's reference to the block after it.
+    @param **blocks pointer to the newest block in the chain, which may be updated.
+    @return a pointer to memory for the next course.
+*/
+static Course *nextCourse(CourseBlock **blocks) 
+{
+    CourseBlock *block = *blocks;
+    // Catalogs on other threads can let go of a shared block at any time.
+    if (block == NULL || block->count >= block->capacity || __atomic_load_n(&block->refs, __ATOMIC_ACQUIRE) > 1) {
+        // Dynamically allocate memory for the new block and its courses.
+        int capacity = block == NULL || block->capacity == 0 ? BLOCK_CAPACITY : block->capacity * DOUBLE_ARRAY;
+        CourseBlock *newBlock = (CourseBlock *) malloc(sizeof(CourseBlock) + capacity * sizeof(Course));
+        newBlock->next = block;
+        newBlock->refs = 1;
+        newBlock->count = 0;
+        newBlock->capacity = capacity;
+        newBlock->mapping = NULL;
+        newBlock->mappingSize = 0;
+        *blocks = block = newBlock;
+    }
+    return &block->courses[block->count];
+}
+
+/** Helper method to read the course on one line of a course file into a partial catalog.
+    @param *partial pointer to the partial catalog.
+    @param *line pointer to the first character of the line.
+    @param *end pointer just past the last character of the line.
+    @return true if the line is a valid course and false otherwise.
+*/
+static bool readCourseLine(PartialCatalog *partial, char const *line, char const *end) 
+{
+    // Parse the line straight into the next course of the newest block.
+    Course *course = nextCourse(&partial->blocks);
+    if (!parseCourse(line, end, course)) {
+        return false;
+    }
+    partial->blocks->count++;
+    return true;
+}
+
+/** Helper method to read all the courses in a piece of a course file into a partial 
+    catalog. Stops at the first invalid line.
+    @param *partial pointer to the partial catalog, with the piece of the file to read.
+*/
+static void readPartial(PartialCatalog *partial) 
+{
+    // A chunk of a mapped file is parsed right from the mapped pages, one line at a time.
+    if (partial->start != NULL) {
+        char const *pos = partial->start;
+        while (pos < partial->end && partial->status == LOAD_OK) {
+            char const *newline = memchr(pos, '\n', partial->end - pos);
+            // The last line might not end with a newline.
+            if (newline == NULL) {
+                newline = partial->end;
+            }
+            if (!readCourseLine(partial, pos, newline)) {
+                partial->status = LOAD_INVALID;
+            }
+            pos = newline + 1;
         }
-        
-        // Check if course number does not have exactly 3 digits.
-        if (strlen(inumber) != NUMBER_LETTERS || !isdigit(inumber[0]) || !isdigit(inumber[1]) || !isdigit(inumber[2])) {
-            fprintf(stderr, "Invalid course file: %s\n", filename);
-            exit(1);
+        return;
+    }
+    
+    // Pipes and other files that can't be mapped are read in large blocks instead.
+    LineReader *reader = makeReader(partial->fd);
+    int len;
+    char *line;
+    while (partial->status == LOAD_OK && (line = nextLine(reader, &len)) != NULL) {
+        if (!readCourseLine(partial, line, line + len)) {
+            partial->status = LOAD_INVALID;
         }
-        // Check if days are not MW or TH.
-        if (strcmp(idays, "MW") != 0 && strcmp(idays, "TH") != 0) {
-            fprintf(stderr, "Invalid course file: %s\n", filename);
-            exit(1);
+    }
+    freeReader(reader);
+}
+
+/** Helper method to add a course to the end of the catalog's list and to its hash index.
+    @param *catalog pointer to the catalog.
+    @param *course pointer to the course, which must not be a duplicate.
+*/
+static void insertCourse(Catalog *catalog, Course *course) 
+{
+    // Create catalog list as a resizable array.
+    if (catalog->count >= catalog->capacity) {
+        catalog->capacity *= DOUBLE_ARRAY;
+        catalog->list = (Course **)realloc(catalog->list, catalog->capacity * sizeof(Course*));
+    }
+    catalog->list[catalog->count] = course;
+    
+    // Keep the hash index at most half full, then add the new course to it.
+    if ((catalog->count + 1) * DOUBLE_ARRAY > catalog->indexCapacity) {
+        growIndex(catalog);
+    }
+    indexCourse(catalog, course);
+    
+    // Increment catalog count.
+    catalog->count++;
+}
+
+/** Helper method to insert the courses in a chain of blocks into the catalog, oldest
+    block first so they go in the order they were read. Stops at the first duplicate.
+    @param *catalog pointer to the catalog.
+    @param *block pointer to the newest block in the chain.
+    @param *nanos array to add the time spent checking and inserting courses to.
+    @return true if none of the courses were duplicates and false otherwise.
+*/
+static bool insertBlocks(Catalog *catalog, CourseBlock *block, long nanos[LOAD_PHASES]) 
+{
+    if (block == NULL) {
+        return true;
+    }
+    if (!insertBlocks(catalog, block->next, nanos)) {
+        return false;
+    }
+    for (int i = 0; i < block->count; i++) {
+        // Check if two or more courses have same course id.
+        long start = statsClock();
+        if (isDuplicate(catalog, block->courses[i].id)) {
+            return false;
         }
-        // Check if name is too long.
-        if (strlen(iname) > NAME_LETTERS) {
-            fprintf(stderr, "Invalid course file: %s\n", filename);
-            exit(1);
+        long checked = statsClock();
+        insertCourse(catalog, &block->courses[i]);
+        if (start != 0) {
+            nanos[PHASE_VALIDATE] += checked - start;
+            nanos[PHASE_INSERT] += statsNow() - checked;
         }
-        // Check if two or more courses have same course id.
-        if (isDuplicate(catalog, idept, inumber)) {
-            fprintf(stderr, "Invalid course file: %s\n", filename);
-            exit(1);
+    }
+    return true;
+}
+
+/** Helper method to count the courses in a chain of blocks.
+    @param *block pointer to the newest block in the chain.
+    @return the number of courses.
+*/
+static int countBlocks(CourseBlock const *block) 
+{
+    int count = 0;
+    for (; block != NULL; block = block->next) {
+        count += block->count;
+    }
+    return count;
+}
+
+/** Helper method to link a partial catalog's chain of blocks in front of the catalog's
+    chain, making them part of the catalog.
+    @param *catalog pointer to the catalog.
+    @param *partial pointer to the partial catalog, which is left with no blocks.
+*/
+static void linkBlocks(Catalog *catalog, PartialCatalog *partial) 
+{
+    if (partial->blocks != NULL) {
+        CourseBlock *last = partial->blocks;
+        while (last->next != NULL) {
+            last = last->next;
+        }
+        // The catalog's reference to its newest block moves to the partial's oldest.
+        last->next = catalog->blocks;
+        catalog->blocks = partial->blocks;
+        partial->blocks = NULL;
+    }
+}
+
+/** Helper method to merge a partial catalog into the catalog. The partial catalog's 
+    blocks become part of the catalog even if there was a problem, since courses before
+    the problem have already been added.
+    @param *catalog pointer to the catalog.
+    @param *partial pointer to the partial catalog.
+    @return LOAD_OK if every course was added, or what went wrong.
+*/
+static LoadStatus mergePartial(Catalog *catalog, PartialCatalog *partial) 
+{
+    // A file that couldn't be opened has no courses to add.
+    if (partial->status == LOAD_CANT_OPEN) {
+        return LOAD_CANT_OPEN;
+    }
+    bool unique = insertBlocks(catalog, partial->blocks, partial->nanos);
+    linkBlocks(catalog, partial);
+    return unique ? partial->status : LOAD_INVALID;
+}
+
+/** The loader struct is the work shared by the loader threads. Each thread takes the
+    next partial catalog that hasn't been read yet until they are all taken.
+*/
+typedef struct {
+    PartialCatalog *partials;
+    int count;
+    int capacity;
+    int next;
+    pthread_mutex_t lock;
+    
+} Loader;
+
+/** Start function for a loader thread. Reads partial catalogs until none are left.
+    @param *arg pointer to the Loader.
+    @return NULL.
+*/
+static void *loaderThread(void *arg) 
+{
+    Loader *loader = (Loader *) arg;
+    while (1) {
+        // Take the next piece of a file to read.
+        pthread_mutex_lock(&loader->lock);
+        int i = loader->next++;
+        pthread_mutex_unlock(&loader->lock);
+        if (i >= loader->count) {
+            return NULL;
         }
-        // Check if time is not valid.
-        if (!isTimesValid(itime)) {
-            fprintf(stderr, "Invalid course file: %s\n", filename);
-            exit(1);
+        long start = statsClock();
+        readPartial(&loader->partials[i]);
+        if (start != 0) {
+            loader->partials[i].nanos[PHASE_PARSE] += statsNow() - start;
         }
+    }
+}
+
+/** Helper method to add a partial catalog for a piece of a course file to the loader.
+    @param *loader pointer to the loader.
+    @param file the index of the course file.
+    @param fd the open course file, or -1 if it couldn't be opened.
+    @param *start pointer to the start of the chunk, or NULL to read the whole file.
+    @param *end pointer just past the end of the chunk.
+*/
+static void addPartial(Loader *loader, int file, int fd, char const *start, char const *end) 
+{
+    // Resizable array of partial catalogs.
+    if (loader->count >= loader->capacity) {
+        loader->capacity *= DOUBLE_ARRAY;
+        loader->partials = (PartialCatalog *) realloc(loader->partials, loader->capacity * sizeof(PartialCatalog));
+    }
+    PartialCatalog *partial = &loader->partials[loader->count++];
+    partial->file = file;
+    partial->fd = fd;
+    partial->start = start;
+    partial->end = end;
+    partial->blocks = NULL;
+    partial->status = fd < 0 ? LOAD_CANT_OPEN : LOAD_OK;
+    memset(partial->nanos, 0, sizeof(partial->nanos));
+}
+
+/** Helper method to split a mapped course file into chunks that end at a newline, with
+    a partial catalog for each one. Files are split into about CHUNKS_PER_WORKER chunks
+    for each worker, but chunks are never smaller than MIN_CHUNK bytes.
+    @param *loader pointer to the loader.
+    @param file the index of the course file.
+    @param fd the open course file.
+    @param *data pointer to the mapped file.
+    @param size the size of the file.
+    @param workers the number of loader threads.
+*/
+static void addChunks(Loader *loader, int file, int fd, char const *data, size_t size, int workers) 
+{
+    size_t chunk = size / ((size_t) workers * CHUNKS_PER_WORKER);
+    if (chunk < MIN_CHUNK || workers == 1) {
+        chunk = size;
+    }
+    
+    char const *start = data;
+    char const *stop = data + size;
+    while (start < stop) {
+        // Move the end of the chunk forward to just after the next newline.
+        char const *end = stop;
+        if ((size_t) (stop - start) > chunk) {
+            char const *newline = memchr(start + chunk, '\n', stop - start - chunk);
+            if (newline != NULL) {
+                end = newline + 1;
+            }
+        }
+        addPartial(loader, file, fd, start, end);
+        start = end;
+    }
+}
+
+LoadStatus loadCourses( Catalog *catalog, char const * const *filenames, int count, int workers, int *failed ) 
+{
+    Loader loader;
+    loader.count = 0;
+    loader.capacity = count + 1;
+    loader.partials = (PartialCatalog *) malloc(loader.capacity * sizeof(PartialCatalog));
+    loader.next = 0;
+    pthread_mutex_init(&loader.lock, NULL);
+    
+    // Open every file up front. Regular files are mapped into memory and split into 
+    // chunks, anything else is read as one piece.
+    int *fds = (int *) malloc((count + 1) * sizeof(int));
+    char **data = (char **) malloc((count + 1) * sizeof(char *));
+    size_t *sizes = (size_t *) malloc((count + 1) * sizeof(size_t));
+    for (int i = 0; i < count; i++) {
+        long start = statsClock();
+        int first = loader.count;
+        fds[i] = open(filenames[i], O_RDONLY);
+        data[i] = MAP_FAILED;
+        sizes[i] = 0;
         
-        // Dynamically allocate memory for list of courses.
-        catalog->list[catalog->count] = (Course *) malloc( sizeof(Course));
-        
-        // Copy over each of the string array field to the right places in the catalog.
-        strcpy(catalog->list[catalog->count]->dept, idept);
-        strcpy(catalog->list[catalog->count]->number, inumber);
-        strcpy(catalog->list[catalog->count]->days, idays);
-        strcpy(catalog->list[catalog->count]->time, itime);
-        strcpy(catalog->list[catalog->count]->name, iname);
- 
-        // Increment catalog count.
-        catalog->count++;
-        
+        struct stat info;
+        if (fds[i] >= 0 && fstat(fds[i], &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            sizes[i] = info.st_size;
+            data[i] = mmap(NULL, sizes[i], PROT_READ, MAP_PRIVATE, fds[i], 0);
+        }
+        if (data[i] != MAP_FAILED) {
+            posix_madvise(data[i], sizes[i], POSIX_MADV_SEQUENTIAL);
+            addChunks(&loader, i, fds[i], data[i], sizes[i], workers);
+        }
+        else {
+            addPartial(&loader, i, fds[i], NULL, NULL);
+        }
+        // Opening and mapping the file counts for its first piece.
+        if (start != 0) {
+            loader.partials[first].nanos[PHASE_READ] = statsNow() - start;
+        }
+    }
+    
+    // Start the extra loader threads, then read pieces on this thread too until they're done.
+    if (workers > loader.count) {
+        workers = loader.count;
+    }
+    pthread_t *threads = (pthread_t *) malloc((workers + 1) * sizeof(pthread_t));
+    int started = 0;
+    while (started < workers - 1 && pthread_create(&threads[started], NULL, loaderThread, &loader) == 0) {
+        started++;
+    }
+    loaderThread(&loader);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&loader.lock);
+    
+    // Merge the pieces in file order, so problems are blamed on the same file as reading
+    // the files one line at a time would.
+    // Each file's pieces are next to each other, so their statistics are added up and
+    // recorded once the last one is merged.
+    LoadStatus status = LOAD_OK;
+    long courses = 0;
+    long nanos[LOAD_PHASES] = { 0 };
+    for (int i = 0; i < loader.count; i++) {
+        PartialCatalog *partial = &loader.partials[i];
+        if (status == LOAD_OK) {
+            courses += countBlocks(partial->blocks);
+            status = mergePartial(catalog, partial);
+            *failed = partial->file;
+            for (int p = 0; p < LOAD_PHASES; p++) {
+                nanos[p] += partial->nanos[p];
+            }
+            if (i + 1 == loader.count || loader.partials[i + 1].file != partial->file) {
+                recordLoad(filenames[partial->file], courses, nanos);
+                courses = 0;
+                memset(nanos, 0, sizeof(nanos));
+            }
+        }
+        // Courses from after a problem are thrown away.
+        else {
+            freeBlocks(partial->blocks);
+        }
+    }
+    
+    // Close the files now that nothing points into them.
+    for (int i = 0; i < count; i++) {
+        if (data[i] != MAP_FAILED) {
+            munmap(data[i], sizes[i]);
+        }
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+    free(fds);
+    free(data);
+    free(sizes);
+    free(loader.partials);
+    return status;
+}
+
+void readCourseFiles( Catalog *catalog, char const * const *filenames, int count, int workers ) 
+{
+    int failed;
+    LoadStatus status = loadCourses(catalog, filenames, count, workers, &failed);
+    
+    // Print to standard error and exit with status of 1 if file can not be open.
+    if (status == LOAD_CANT_OPEN) {
+        fprintf(stderr, "Can't open file: %s\n", filenames[failed]);
+        exit(1);
+    }
+    // Print to standard error and exit with status of 1 if file has an invalid course.
+    if (status == LOAD_INVALID) {
+        fprintf(stderr, "Invalid course file: %s\n", filenames[failed]);
+        exit(1);
+    }
+}
+
+void readCourses( char const *filename, Catalog *catalog ) 
+{
+    readCourseFiles(catalog, &filename, 1, 1);
+}
+
+/** Helper method to gather the courses in a chain of blocks, oldest block first so they
+    are in the order they were read.
+    @param *block pointer to the newest block in the chain.
+    @param **courses array to add pointers to the courses to.
+    @param count the number of courses already in the array.
+    @return the number of courses in the array after adding these.
+*/
+static int gatherBlocks(CourseBlock *block, Course **courses, int count) 
+{
+    if (block == NULL) {
+        return count;
+    }
+    count = gatherBlocks(block->next, courses, count);
+    for (int i = 0; i < block->count; i++) {
+        courses[count++] = &block->courses[i];
+    }
+    return count;
+}
+
+/** Helper method to merge a sorted run of new courses into a sorted view that has room
+    for them after its courses. Merging starts from the back, so only the courses that
+    sort after the first new one are moved.
+    @param **view the view, with room for count + n courses.
+    @param count the number of courses in the view.
+    @param **run the new courses, sorted the same way as the view.
+    @param n the number of new courses.
+    @param *compare the comparison the view and the run are sorted by.
+*/
+static void mergeRun(Course **view, int count, Course **run, int n, int (*compare)(void const *va, void const *vb)) 
+{
+    int i = count - 1;
+    int j = n - 1;
+    for (int k = count + n - 1; j >= 0; k--) {
+        if (i >= 0 && compare(&view[i], &run[j]) > 0) {
+            view[k] = view[i--];
+        }
+        else {
+            view[k] = run[j--];
+        }
+    }
+}
+
+/** Helper method to merge new courses into the catalog's views and bucket indexes, which
+    were built before the courses were added.
+    @param *catalog pointer to the catalog, whose count includes the new courses.
+    @param **added the new courses, sorted by course id.
+    @param n the number of new courses.
+*/
+static void mergeViews(Catalog *catalog, Course **added, int n) 
+{
+    long start = statsClock();
+    int old = catalog->count - n;
+    
+    // Merge the new courses into the sorted views.
+    catalog->byId = (Course **) realloc(catalog->byId, (catalog->count + 1) * sizeof(Course*));
+    mergeRun(catalog->byId, old, added, n, compareId);
+    Course **byName = (Course **) malloc((n + 1) * sizeof(Course*));
+    memcpy(byName, added, n * sizeof(Course*));
+    qsort(byName, n, sizeof(Course*), compareName);
+    catalog->byName = (Course **) realloc(catalog->byName, (catalog->count + 1) * sizeof(Course*));
+    mergeRun(catalog->byName, old, byName, n, compareName);
+    free(byName);
+    
+    // Each department now starts after the new courses in the departments before it too.
+    int before = 0;
+    for (int d = 0; d <= DEPARTMENT_COUNT; d++) {
+        while (before < n && added[before]->id / NUMBERS_PER_DEPARTMENT < d) {
+            before++;
+        }
+        catalog->deptStart[d] += before;
+    }
+    
+    // Counting sort the new courses into timeslot buckets, in id order like the others.
+    int addedStart[TIMESLOT_COUNT + 1] = { 0 };
+    for (int i = 0; i < n; i++) {
+        addedStart[added[i]->slot + 1]++;
+    }
+    for (int s = 0; s < TIMESLOT_COUNT; s++) {
+        addedStart[s + 1] += addedStart[s];
+    }
+    int next[TIMESLOT_COUNT];
+    memcpy(next, addedStart, sizeof(next));
+    Course **bySlot = (Course **) malloc((n + 1) * sizeof(Course*));
+    for (int i = 0; i < n; i++) {
+        bySlot[next[added[i]->slot]++] = added[i];
     }
+    
+    // Every bucket moves over by the new courses in the buckets before it. Merging each
+    // bucket from the back, starting with the last bucket, never writes over a course
+    // that hasn't been moved yet.
+    catalog->bySlot = (Course **) realloc(catalog->bySlot, (catalog->count + 1) * sizeof(Course*));
+    for (int s = TIMESLOT_COUNT - 1; s >= 0; s--) {
+        int start = catalog->slotStart[s];
+        int count = catalog->slotStart[s + 1] - start;
+        memmove(catalog->bySlot + start + addedStart[s], catalog->bySlot + start, count * sizeof(Course*));
+        mergeRun(catalog->bySlot + start + addedStart[s], count, bySlot + addedStart[s], 
+                 addedStart[s + 1] - addedStart[s], compareId);
+    }
+    for (int s = 0; s <= TIMESLOT_COUNT; s++) {
+        catalog->slotStart[s] += addedStart[s];
+    }
+    free(bySlot);
+    
+    // The new courses are at the end of the list, so in each trigram bucket they go
+    // after the courses already there. Buckets are moved over from the last one back,
+    // like the timeslot buckets.
+    int *gramAdded = (int *) malloc((TRIGRAM_BUCKETS + 1) * sizeof(int));
+    int *grams = indexTrigrams(catalog->list + old, n, old, gramAdded);
+    catalog->byGram = (int *) realloc(catalog->byGram, (catalog->gramStart[TRIGRAM_BUCKETS] + gramAdded[TRIGRAM_BUCKETS] + 1) * sizeof(int));
+    for (int b = TRIGRAM_BUCKETS - 1; b >= 0; b--) {
+        int start = catalog->gramStart[b];
+        int count = catalog->gramStart[b + 1] - start;
+        memmove(catalog->byGram + start + gramAdded[b], catalog->byGram + start, count * sizeof(int));
+        memcpy(catalog->byGram + start + gramAdded[b] + count, grams + gramAdded[b], 
+               (gramAdded[b + 1] - gramAdded[b]) * sizeof(int));
+    }
+    for (int b = 0; b <= TRIGRAM_BUCKETS; b++) {
+        catalog->gramStart[b] += gramAdded[b];
+    }
+    free(grams);
+    free(gramAdded);
+    recordTime(TIMER_MERGE_VIEWS, start);
+}
 
+LoadStatus appendCourses( Catalog *catalog, char const *filename ) 
+{
+    // Read the whole file into a partial catalog of its own, from the mapped file if it
+    // can be mapped.
+    long start = statsClock();
+    PartialCatalog partial;
+    partial.file = 0;
+    partial.fd = open(filename, O_RDONLY);
+    partial.start = NULL;
+    partial.end = NULL;
+    partial.blocks = NULL;
+    partial.status = LOAD_OK;
+    memset(partial.nanos, 0, sizeof(partial.nanos));
+    if (partial.fd < 0) {
+        return LOAD_CANT_OPEN;
+    }
+    char *data = MAP_FAILED;
+    struct stat info;
+    if (fstat(partial.fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, partial.fd, 0);
+    }
+    if (data != MAP_FAILED) {
+        partial.start = data;
+        partial.end = data + info.st_size;
+    }
+    long opened = statsClock();
+    readPartial(&partial);
+    if (data != MAP_FAILED) {
+        munmap(data, info.st_size);
+    }
+    close(partial.fd);
+    long parsed = statsClock();
+    
+    // Check every new course before adding any of them. Sorted by id, a course that is
+    // in the file twice is next to itself.
+    int n = countBlocks(partial.blocks);
+    Course **added = (Course **) malloc((n + 1) * sizeof(Course*));
+    gatherBlocks(partial.blocks, added, 0);
+    LoadStatus status = partial.status;
+    for (int i = 0; i < n && status == LOAD_OK; i++) {
+        if (isDuplicate(catalog, added[i]->id)) {
+            status = LOAD_INVALID;
+        }
+    }
+    Course **sorted = (Course **) malloc((n + 1) * sizeof(Course*));
+    memcpy(sorted, added, n * sizeof(Course*));
+    qsort(sorted, n, sizeof(Course*), compareId);
+    for (int i = 1; i < n && status == LOAD_OK; i++) {
+        if (sorted[i - 1]->id == sorted[i]->id) {
+            status = LOAD_INVALID;
+        }
+    }
+    if (status != LOAD_OK) {
+        freeBlocks(partial.blocks);
+        free(added);
+        free(sorted);
+        return status;
+    }
+    
+    // Add the courses in the order they were read, then merge them into the views if
+    // they are already built.
+    long checked = statsClock();
+    for (int i = 0; i < n; i++) {
+        insertCourse(catalog, added[i]);
+    }
+    linkBlocks(catalog, &partial);
+    if (start != 0) {
+        partial.nanos[PHASE_READ] = opened - start;
+        partial.nanos[PHASE_PARSE] = parsed - opened;
+        partial.nanos[PHASE_VALIDATE] = checked - parsed;
+        partial.nanos[PHASE_INSERT] = statsNow() - checked;
+        recordLoad(filename, n, partial.nanos);
+    }
+    if (catalog->byId != NULL) {
+        mergeViews(catalog, sorted, n);
+    }
+    free(added);
+    free(sorted);
+    return LOAD_OK;
+}
+
+int compareId(void const *va, void const *vb) 
+{
+    // Convert void pointers to (const) pointers to courses.
+    Course const *a = *(Course const **)va;
+    Course const *b = *(Course const **)vb;
+    
+    // The packed course id orders by department and then by number.
+    if (a->id < b->id) {
+        return ORDER_BEFORE;
+    }
+    else if (a->id > b->id) {
+        return ORDER_AFTER;
+    }
+    return EQUAL;
+}
+
+int compareName(void const *va, void const *vb) 
+{
+    // Convert void pointers to (const) pointers to courses.
+    Course const *a = *(Course const **)va;
+    Course const *b = *(Course const **)vb;
+    
+    // Compare the name for two courses first.
+    int order = strcmp(a->name, b->name);
+    if (order < 0) {
+        return ORDER_BEFORE;
+    }
+    else if (order > 0) {
+        return ORDER_AFTER;
+    }
+    // If the name are the same, compare the packed course id of two courses.
+    return compareId(va, vb);
 }
 
 void sortCourses( Catalog *catalog, int (* compare) (void const *va, void const *vb )) 
@@ -180,16 +1121,156 @@ void sortCourses( Catalog *catalog, int (* compare) (void const *va, void const
     qsort(catalog->list, catalog->count, sizeof(Course*), compare);
 }
 
-void listCourses( Catalog *catalog, bool (*test)( Course const *course, char const *str1, char const *str2 ), char const *str1, char const *str2 ) 
+void buildViews( Catalog *catalog ) 
 {
-    // Print the header.
-    printf("Course  Name                           Timeslot\n");
-    // Loop through catalog.
+    long start = statsClock();
+    
+    // Throw away views from before any courses were added.
+    free(catalog->byId);
+    free(catalog->byName);
+    free(catalog->deptStart);
+    free(catalog->bySlot);
+    free(catalog->gramStart);
+    free(catalog->byGram);
+    
+    // Copy the list of courses into each view and sort it in that view's order.
+    catalog->byId = (Course **) malloc((catalog->count + 1) * sizeof(Course*));
+    catalog->byName = (Course **) malloc((catalog->count + 1) * sizeof(Course*));
+    memcpy(catalog->byId, catalog->list, catalog->count * sizeof(Course*));
+    memcpy(catalog->byName, catalog->list, catalog->count * sizeof(Course*));
+    qsort(catalog->byId, catalog->count, sizeof(Course*), compareId);
+    qsort(catalog->byName, catalog->count, sizeof(Course*), compareName);
+    
+    // Courses of a department are next to each other in byId, so the department index
+    // only needs where each department starts. Count the courses in each department.
+    catalog->deptStart = (int *) calloc(DEPARTMENT_COUNT + 1, sizeof(int));
+    for (int i = 0; i < catalog->count; i++) {
+        catalog->deptStart[catalog->byId[i]->id / NUMBERS_PER_DEPARTMENT + 1]++;
+    }
+    // Add up the counts so each department starts after all the ones before it.
+    for (int d = 0; d < DEPARTMENT_COUNT; d++) {
+        catalog->deptStart[d + 1] += catalog->deptStart[d];
+    }
+    
+    // Counting sort byId into timeslot buckets, which keeps each bucket in id order.
+    int next[TIMESLOT_COUNT] = { 0 };
+    for (int i = 0; i < catalog->count; i++) {
+        next[catalog->byId[i]->slot]++;
+    }
+    catalog->slotStart[0] = 0;
+    for (int s = 0; s < TIMESLOT_COUNT; s++) {
+        catalog->slotStart[s + 1] = catalog->slotStart[s] + next[s];
+        next[s] = catalog->slotStart[s];
+    }
+    catalog->bySlot = (Course **) malloc((catalog->count + 1) * sizeof(Course*));
     for (int i = 0; i < catalog->count; i++) {
-        Course *course = catalog->list[i];
+        catalog->bySlot[next[catalog->byId[i]->slot]++] = catalog->byId[i];
+    }
+    
+    // Index the names by trigram, in list order.
+    catalog->gramStart = (int *) malloc((TRIGRAM_BUCKETS + 1) * sizeof(int));
+    catalog->byGram = indexTrigrams(catalog->list, catalog->count, 0, catalog->gramStart);
+    recordTime(TIMER_BUILD_VIEWS, start);
+}
+
+int trigramBucket( char const *text ) 
+{
+    // Pack the three characters in lower case, then keep the top bits of a
+    // multiplicative hash of them.
+    uint32_t key = 0;
+    for (int i = 0; i < TRIGRAM_LEN; i++) {
+        key = key << 8 | (unsigned char) tolower((unsigned char) text[i]);
+    }
+    return (key * 2654435761u) >> (32 - TRIGRAM_BITS);
+}
+
+/** Helper method to find the trigram buckets a course's name is in, each only once.
+    @param *course pointer to the course.
+    @param mark a number that is different for each course.
+    @param *seen array of the mark of the last course found in each bucket.
+    @param *buckets array with room for NAME_LETTERS buckets.
+    @return the number of buckets.
+*/
+static int nameTrigrams(Course const *course, int mark, int *seen, int *buckets) 
+{
+    int count = 0;
+    for (int i = 0; course->name[i] && course->name[i + 1] && course->name[i + 2]; i++) {
+        int bucket = trigramBucket(course->name + i);
+        if (seen[bucket] != mark) {
+            seen[bucket] = mark;
+            buckets[count++] = bucket;
+        }
+    }
+    return count;
+}
+
+int *indexTrigrams( Course * const *courses, int n, int first, int *start ) 
+{
+    // Count the courses in each bucket, then add up the counts so each bucket starts
+    // after all the ones before it. Courses are marked by their position in the first
+    // pass and by the position after n in the second.
+    int buckets[NAME_LETTERS];
+    int *seen = (int *) malloc(TRIGRAM_BUCKETS * sizeof(int));
+    memset(seen, -1, TRIGRAM_BUCKETS * sizeof(int));
+    memset(start, 0, (TRIGRAM_BUCKETS + 1) * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        int count = nameTrigrams(courses[i], i, seen, buckets);
+        for (int j = 0; j < count; j++) {
+            start[buckets[j] + 1]++;
+        }
+    }
+    for (int b = 0; b < TRIGRAM_BUCKETS; b++) {
+        start[b + 1] += start[b];
+    }
+    
+    // Then put each course's position in its buckets, in order.
+    int *next = (int *) malloc(TRIGRAM_BUCKETS * sizeof(int));
+    memcpy(next, start, TRIGRAM_BUCKETS * sizeof(int));
+    int *grams = (int *) malloc((start[TRIGRAM_BUCKETS] + 1) * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        int count = nameTrigrams(courses[i], n + i, seen, buckets);
+        for (int j = 0; j < count; j++) {
+            grams[next[buckets[j]]++] = first + i;
+        }
+    }
+    free(next);
+    free(seen);
+    return grams;
+}
+
+Course **departmentView( Catalog const *catalog, int dept, int *count ) 
+{
+    *count = catalog->deptStart[dept + 1] - catalog->deptStart[dept];
+    return catalog->byId + catalog->deptStart[dept];
+}
+
+Course **timeslotView( Catalog const *catalog, int slot, int *count ) 
+{
+    *count = catalog->slotStart[slot + 1] - catalog->slotStart[slot];
+    return catalog->bySlot + catalog->slotStart[slot];
+}
+
+int const *trigramView( Catalog const *catalog, int bucket, int *count ) 
+{
+    *count = catalog->gramStart[bucket + 1] - catalog->gramStart[bucket];
+    return catalog->byGram + catalog->gramStart[bucket];
+}
+
+void printCourse( Output *out, Course const *course ) 
+{
+    putBytes(out, course->row, ROW_LEN);
+}
+
+void listCourses( Output *out, Course * const *view, int count, bool (*test)( Course const *course, int key ), int key ) 
+{
+    // Print the header.
+    putText(out, LIST_HEADER);
+    // Loop through the view.
+    for (int i = 0; i < count; i++) {
+        Course *course = view[i];
         // Print all the matching courses in the catalog.
-        if (test(course, str1, str2)) {
-            printf("%3s %3s %-30s %2s %5s\n", course->dept, course->number, course->name, course->days, course->time);
+        if (test(course, key)) {
+            printCourse(out, course);
         }
     }  
 }
@@ -3,7 +3,13 @@
     This is the header file for the components that make/free catalog as well as 
     read, sort, and list courses.
 */
+#ifndef CATALOG_H
+#define CATALOG_H
+
 #include <stdbool.h>
+#include <stddef.h>
+
+#include "output.h"
 
 /** Length of department field accounting for null character. */
 #define DEPARTMENT_LEN 4
@@ -41,8 +47,63 @@
 /** Number of letters in name field */
 #define NAME_LETTERS 30
 
+/** Number of distinct course numbers in one department */
+#define NUMBERS_PER_DEPARTMENT 1000
+
+/** Number of distinct departments, one for each three uppercase letter string */
+#define DEPARTMENT_COUNT 17576
+
+/** Number of valid day patterns, MW and TH */
+#define NUMBER_OF_VALID_DAYS 2
+
+/** Number of distinct timeslots, one for each valid days and time pair */
+#define TIMESLOT_COUNT 12
+
+/** The number of courses the first block of a catalog has room for */
+#define BLOCK_CAPACITY 64
+
+/** The smallest chunk, in bytes, that loader threads split a course file into */
+#define MIN_CHUNK 262144
+
+/** The number of chunks per loader thread that a large course file is split into */
+#define CHUNKS_PER_WORKER 4
+
+/** First param order before second one */
+#define ORDER_BEFORE -1
+
+/** First param order after second one */
+#define ORDER_AFTER 1
+
+/** First param equal to second param */
+#define EQUAL 0
+
+/** The initial number of slots in the course id hash index, must be a power of two */
+#define INDEX_CAPACITY 16
+
+/** Length of a course's row in the course lists, "%3s %3s %-30s %2s %5s\n" */
+#define ROW_LEN 48
+
+/** Length of the course id at the start of a row, department, space and number */
+#define ROW_ID_LEN 7
+
+/** Number of characters in a trigram of a course name */
+#define TRIGRAM_LEN 3
+
+/** Number of bits in a bucket of the name trigram index */
+#define TRIGRAM_BITS 16
+
+/** Number of buckets in the name trigram index */
+#define TRIGRAM_BUCKETS (1 << TRIGRAM_BITS)
+
+/** The header line printed before a list of courses */
+#define LIST_HEADER "Course  Name                           Timeslot\n"
+
 /** This is the course struct with five fields representing the course department,
-    number, days, time, and name. All of the fields will be stored as strings.
+    number, days, time, and name. All of the fields will be stored as strings. The
+    id and slot fields hold the course id and timeslot packed into integers, so
+    courses can be ordered and matched without comparing strings. Row is the course
+    already formatted for the course lists, newline included but no null character,
+    so listing a course is just copying it.
 */
 typedef struct {
     char dept[DEPARTMENT_LEN];
@@ -51,16 +112,65 @@ typedef struct {
     char time[TIME_LEN];
     char name[NAME_LEN];
     
+    int id;
+    int slot;
+    char row[ROW_LEN];
+    
 } Course;
 
+/** The course block struct is a slab of courses stored next to each other in memory.
+    A catalog keeps its courses in a chain of blocks linked by next, newest first. Each
+    block has room for twice as many courses as the one before it, so even a large
+    catalog only needs a few blocks, and courses never move once they are added.
+    Copies of a catalog share the older part of the chain, so refs counts the catalogs
+    and newer blocks pointing at a block, and it is freed when the last one lets go.
+    A block can also stand for a compiled image mapped into memory at mapping, which
+    holds the courses instead of the block and is unmapped when the block is freed.
+*/
+typedef struct CourseBlockStruct {
+    struct CourseBlockStruct *next;
+    int refs;
+    int count;
+    int capacity;
+    void *mapping;
+    size_t mappingSize;
+    Course courses[];
+    
+} CourseBlock;
+
 /** The catalog struct contain fields to store a resizable array of pointers to Course.
     Count and capacity field will be used to resize the array and the list field will
-    keep track of all the courses.
+    keep track of all the courses, which are stored in the chain of blocks. The index
+    field is an open addressing hash table keyed on course id (department and number)
+    so a course can be found without scanning the list. The byId and byName fields are
+    copies of the list sorted by course id and by name, built once by buildViews() after
+    all the courses are read. buildViews() also fills in two bucket indexes over the
+    courses. The courses of department d are byId[deptStart[d]] up to
+    byId[deptStart[d + 1]], and the courses in timeslot s are bySlot[slotStart[s]] up to
+    bySlot[slotStart[s + 1]], both sorted by course id. The names are indexed by trigram
+    the same way: the courses with a run of three characters in their name that hashes
+    to bucket b, ignoring case, are byGram[gramStart[b]] up to byGram[gramStart[b + 1]],
+    as positions in list, in list order. A catalog loaded from a compiled image keeps
+    its courses in the image, which is in its chain of blocks.
 */
 typedef struct {
     Course **list;
     int count;
     int capacity;
+    CourseBlock *blocks;
+    
+    Course **index;
+    int indexCapacity;
+    
+    Course **byId;
+    Course **byName;
+    
+    int *deptStart;
+    Course **bySlot;
+    int slotStart[TIMESLOT_COUNT + 1];
+    
+    int *gramStart;
+    int *byGram;
     
 } Catalog;
 
@@ -74,12 +184,73 @@ Catalog *makeCatalog();
 */
 void freeCatalog(Catalog *catalog);
 
-/** This function read all the courses from a course file.
+/** This function makes a copy of a catalog that can have courses added to it without
+    changing the original. The copy has its own views and indexes, but shares the
+    courses, which stay around until both catalogs are freed.
+    @param *catalog pointer to the catalog.
+    @return a pointer to the new catalog.
+*/
+Catalog *copyCatalog( Catalog const *catalog );
+
+/** This function hands the catalog a compiled image that its courses are stored in. The
+    image is unmapped once no catalog sharing its courses is left.
+    @param *catalog pointer to the catalog.
+    @param *data pointer to the mapped image.
+    @param size the size of the mapping.
+*/
+void adoptMapping( Catalog *catalog, void *data, size_t size );
+
+/** This function works out how much memory a catalog takes up, counting its courses,
+    or the image they're mapped from, along with its list, index and views.
+    @param *catalog pointer to the catalog.
+    @return the number of bytes.
+*/
+size_t catalogSize( Catalog const *catalog );
+
+/** The ways reading course files into a catalog can turn out. */
+typedef enum { LOAD_OK, LOAD_CANT_OPEN, LOAD_INVALID } LoadStatus;
+
+/** This function read all the courses from a course file. Print to standard error and
+    exit with status of 1 if the file can't be opened or isn't valid.
     @param *filename pointer to the course file.
     @param *catalog pointer to the catalog.
 */
 void readCourses( char const *filename, Catalog *catalog );
 
+/** This function read all the courses from several course files, in order. With more
+    than one worker, files and newline aligned chunks of large files are parsed at the
+    same time on their own threads and then merged in order. Print to standard error
+    and exit with status of 1 if a file can't be opened or isn't valid, blaming the same
+    file as reading the files one at a time.
+    @param *catalog pointer to the catalog.
+    @param *filenames array of pointers to the course files.
+    @param count the number of course files.
+    @param workers the number of threads to read files with.
+*/
+void readCourseFiles( Catalog *catalog, char const * const *filenames, int count, int workers );
+
+/** This function read all the courses from several course files like readCourseFiles(),
+    but report a problem instead of exiting. Courses from files before the problem, and
+    from lines before it in the file that had it, stay in the catalog.
+    @param *catalog pointer to the catalog.
+    @param *filenames array of pointers to the course files.
+    @param count the number of course files.
+    @param workers the number of threads to read files with.
+    @param *failed pointer to where the index of the file that had a problem is stored.
+    @return LOAD_OK if every course was read, or what went wrong.
+*/
+LoadStatus loadCourses( Catalog *catalog, char const * const *filenames, int count, int workers, int *failed );
+
+/** This function adds the courses from another course file to a catalog. The whole file
+    is read and checked first, so if there is a problem with it the catalog doesn't
+    change. If the views are built, the new courses are merged into them instead of
+    building them again, so the work mostly depends on how many courses are added.
+    @param *catalog pointer to the catalog.
+    @param *filename pointer to the course file.
+    @return LOAD_OK if every course was added, or what went wrong.
+*/
+LoadStatus appendCourses( Catalog *catalog, char const *filename );
+
 /** This function sort the courses in the catalog. It uses qsort() function 
     with the function parameter to sort the courses in the schedule.
     @param *catalog pointer to the catalog.
@@ -87,17 +258,133 @@ void readCourses( char const *filename, Catalog *catalog );
 */
 void sortCourses( Catalog *catalog, int (* compare) (void const *va, void const *vb ));
 
-/** This function print all of courses in the lsit. Uses funciton pointer parameter 
-    to determine what courses to print.
+/** Comparison function used to sort courses by courseID.
+    @param *va a constant void pointer to a course pointer.
+    @param *vb another constant void pointer to a course pointer.
+    @return -1 if the course given by first parameter should be ordered before the second one,
+    0 if the course given by first parameter is equal to the second one,
+    1 if the course given by first parameter should be ordered after the second one,
+*/
+int compareId( void const *va, void const *vb );
+
+/** Comparison function used to sort courses by course name, followed by course ID, if the
+    name are identical.
+    @param *va a constant void pointer to a course pointer.
+    @param *vb another constant void pointer to a course pointer.
+    @return -1 if the course given by first parameter should be ordered before the second one,
+    0 if the course given by first parameter is equal to the second one,
+    1 if the course given by first parameter should be ordered after the second one,
+*/
+int compareName( void const *va, void const *vb );
+
+/** This function build the sorted views of the catalog, byId and byName, and the
+    department and timeslot bucket indexes. It must be called again after more 
+    courses are read.
+    @param *catalog pointer to the catalog.
+*/
+void buildViews( Catalog *catalog );
+
+/** This function find all the courses in a department using the department index.
+    @param *catalog pointer to the catalog.
+    @param dept the department packed with packDepartment().
+    @param *count pointer to where the number of courses found will be stored.
+    @return the courses in the department, sorted by course id.
+*/
+Course **departmentView( Catalog const *catalog, int dept, int *count );
+
+/** This function find all the courses in a timeslot using the timeslot index.
+    @param *catalog pointer to the catalog.
+    @param slot the timeslot packed with packTimeslot().
+    @param *count pointer to where the number of courses found will be stored.
+    @return the courses in the timeslot, sorted by course id.
+*/
+Course **timeslotView( Catalog const *catalog, int slot, int *count );
+
+/** This function hash a trigram into a bucket of the name trigram index. Letters are
+    the same bucket in upper and lower case.
+    @param *text pointer to the three characters of the trigram.
+    @return the bucket.
+*/
+int trigramBucket( char const *text );
+
+/** This function index the names of some courses by trigram, with a counting sort that
+    keeps each bucket in the order the courses are given.
+    @param *courses array of pointers to the courses.
+    @param n the number of courses.
+    @param first the position to store for the first course, counting up from there.
+    @param *start array of TRIGRAM_BUCKETS + 1 ints where each bucket's start is stored.
+    @return the dynamically allocated positions of the courses in each bucket.
+*/
+int *indexTrigrams( Course * const *courses, int n, int first, int *start );
+
+/** This function find the courses whose name may have a trigram in it, using the name
+    trigram index. Other trigrams that hash to the same bucket are in there too.
     @param *catalog pointer to the catalog.
+    @param bucket the bucket from trigramBucket().
+    @param *count pointer to where the number of courses found will be stored.
+    @return the positions of the courses in the catalog's list, in order.
+*/
+int const *trigramView( Catalog const *catalog, int bucket, int *count );
+
+/** This function print one course as a row of the course lists, using the row formatted
+    when the course was read.
+    @param *out where to print the row.
+    @param *course pointer to the course.
+*/
+void printCourse( Output *out, Course const *course );
+
+/** This function print all of courses in a view of the catalog, in the order of the
+    view. Uses funciton pointer parameter to determine what courses to print.
+    @param *out where to print the courses.
+    @param *view array of pointers to the courses, usually byId or byName.
+    @param count number of courses in the view.
     @param *test the test function.
-    @param *str1 first void constant.
-    @param *str2 second void constant.
+    @param key value passed on to the test function.
+*/
+void listCourses( Output *out, Course * const *view, int count, bool (*test)( Course const *course, int key ), int key );
+
+/** This function look up a course in the catalog by its course id using the hash index.
+    @param *catalog pointer to the catalog.
+    @param *dept pointer to the course department.
+    @param *number pointer to the course number.
+    @return a pointer to the matching course or NULL if there is no such course.
 */
-void listCourses( Catalog *catalog, bool (*test)( Course const *course, char const *str1, char const *str2 ), char const *str1, char const *str2 );
+Course *findCourse( Catalog const *catalog, char const *dept, char const *number );
+
+/** This function look up a course in the catalog by its packed course id.
+    @param *catalog pointer to the catalog.
+    @param id the packed course id.
+    @return a pointer to the matching course or NULL if there is no such course.
+*/
+Course *findCourseById( Catalog const *catalog, int id );
 
 /** Helper method to check if the time given is one of the 6 valid times.
     @param *timeStr pointer to a given course time.
     @return true if the given time is valid and false otherwise.
 */
 bool isTimesValid(char *timeStr);
+
+/** This function pack a department into an integer. Departments that are three 
+    uppercase letters get a value from 0 to DEPARTMENT_COUNT - 1 in alphabetical order.
+    @param *dept pointer to the department.
+    @return the packed department or -1 if the department is not three uppercase letters.
+*/
+int packDepartment( char const *dept );
+
+/** This function pack a course id into an integer. Packed ids are ordered the same
+    way as comparing the department and then the number as strings.
+    @param *dept pointer to the course department.
+    @param *number pointer to the course number.
+    @return the packed course id or -1 if the department or number is not valid.
+*/
+int packCourseId( char const *dept, char const *number );
+
+/** This function pack a timeslot into an integer. Timeslots get a value from 0 to
+    TIMESLOT_COUNT - 1, ordered by days and then by time of day.
+    @param *days pointer to the days, MW or TH.
+    @param *timeStr pointer to one of the 6 valid times.
+    @return the packed timeslot or -1 if the days or time are not valid.
+*/
+int packTimeslot( char const *days, char const *timeStr );
+
+#endif
@@ -0,0 +1,547 @@
+/** @file command.c
+    @author Huy Nguyen (hqnguyen)
+    This component carries out the users commands like add, drop, list, calendar, student,
+    stats and quit, printing their results to an Output.
+*/
+
+// Needed for strtok_r() with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "command.h"
+#include "query.h"
+#include "search.h"
+#include "solver.h"
+#include "stats.h"
+
+/** Number of words of a command line stored in the command state */
+#define COMMAND_WORDS 4
+
+/** There need to be exactly 3 character in department field */
+#define DEPARTMENT_CHAR 3
+
+/** This static boolean function is used to pass in a pointer to the test function so that 
+    it will print all of the courses.
+    @param *course pointer to course.
+    @param key one of the parameter of the test function that is not used in this case.
+    @return true always to print all the courses.
+*/
+static bool truePointer(Course const *course, int key) 
+{
+    return true;
+}
+
+/** This function add a course to the schedule. 
+    @param *out where to print if the course can't be added.
+    @param *schedule pointer to the schedule.
+    @param *catalog pointer to the catalog.
+    @param *dept the pointer to the given course department.
+    @param *number the pointer to the given course number.
+*/
+static void addCourse(Output *out, Schedule *schedule, Catalog *catalog, char *dept, char *number) 
+{
+    // Look up the given course id with the catalog's hash index.
+    Course *course = findCourse(catalog, dept, number);
+    
+    // The course is invalid if it isn't in the catalog, or if the schedule can't take it.
+    if (course == NULL || !addToSchedule(schedule, course)) {
+        putText(out, "Invalid command\n");
+    }
+}
+
+/** This function drop a course from the schedule. 
+    @param *out where to print if the course can't be dropped.
+    @param *schedule pointer to the schedule.
+    @param *catalog pointer to the catalog.
+    @param *dept the pointer to the given course department.
+    @param *number the pointer to the given course number.
+*/
+static void dropCourse(Output *out, Schedule *schedule, Catalog *catalog, char *dept, char *number) 
+{  
+    // Look up the given course id with the catalog's hash index.
+    Course *course = findCourse(catalog, dept, number);
+    
+    // If the course was not in the schedule, print invalid command.
+    if (course == NULL || !dropFromSchedule(schedule, course)) {
+        putText(out, "Invalid command\n");
+    }
+}
+
+/** Helper method to read a count or a priority, a number from 1 up to a limit.
+    @param *word pointer to the word, or NULL if the line ended.
+    @param max the largest the number can be.
+    @return the number, or -1 if the word isn't a number in range.
+*/
+static int parsePositive(char const *word, int max) 
+{
+    int value = 0;
+    for (int i = 0; word && word[i]; i++) {
+        if (!isdigit(word[i]) || value > max) {
+            return -1;
+        }
+        value = value * 10 + (word[i] - '0');
+    }
+    return value >= 1 && value <= max ? value : -1;
+}
+
+/** This function finds the best schedules for the current student out of a wishlist of
+    courses and prints them. The command is autoschedule, then optionally top and the
+    number of schedules wanted, then each course's department and number, with a colon
+    and the course's priority after the number if it's not 1.
+    @param *out where to print the schedules.
+    @param *schedule pointer to the student's schedule, which isn't changed.
+    @param *catalog pointer to the catalog.
+    @param *input pointer to the command line.
+    @return false if the wishlist is invalid and true otherwise.
+*/
+static bool autoschedule(Output *out, Schedule const *schedule, Catalog *catalog, char const *input) 
+{
+    // Split a copy of the line into words, skipping autoschedule. Commands run on
+    // several threads at once, so the position in the line is kept here.
+    char *line = (char *) malloc(strlen(input) + 1);
+    strcpy(line, input);
+    char *rest;
+    strtok_r(line, " \t", &rest);
+    char *word = strtok_r(NULL, " \t", &rest);
+    int top = 1;
+    if (word && strcmp(word, "top") == 0) {
+        top = parsePositive(strtok_r(NULL, " \t", &rest), SOLUTIONS_MAX);
+        word = strtok_r(NULL, " \t", &rest);
+    }
+
+    // Each course is two words. The wishlist can't be longer than the line.
+    Wish *wishes = (Wish *) malloc((strlen(input) / 2 + 1) * sizeof(Wish));
+    int count = 0;
+    bool valid = top > 0 && word != NULL;
+    while (valid && word) {
+        char *dept = word;
+        char *number = strtok_r(NULL, " \t", &rest);
+        char *priority = number ? strchr(number, ':') : NULL;
+        if (priority) {
+            *priority++ = '\0';
+        }
+        wishes[count].course = number ? findCourse(catalog, dept, number) : NULL;
+        wishes[count].priority = priority ? parsePositive(priority, WISH_PRIORITY_MAX) : 1;
+        valid = wishes[count].course != NULL && wishes[count].priority > 0;
+        // A course can only be on the wishlist once.
+        for (int i = 0; valid && i < count; i++) {
+            valid = wishes[i].course != wishes[count].course;
+        }
+        count++;
+        word = strtok_r(NULL, " \t", &rest);
+    }
+
+    if (valid) {
+        Solution solutions[SOLUTIONS_MAX];
+        int found = solveSchedule(schedule, wishes, count, solutions, top);
+        char heading[MAX_STRING_LEN];
+        for (int i = 0; i < found; i++) {
+            if (i > 0) {
+                putBytes(out, "\n", 1);
+            }
+            snprintf(heading, sizeof(heading), "Schedule %d, priority %d\n", i + 1, solutions[i].priority);
+            putText(out, heading);
+            listSchedule(out, &solutions[i].schedule);
+        }
+    }
+    free(wishes);
+    free(line);
+    return valid;
+}
+
+/** This function prints why a course file couldn't be read, the same way as when the
+    program starts.
+    @param *out where to print.
+    @param status what went wrong.
+    @param *filename the file that had the problem.
+*/
+static void printLoadStatus(Output *out, LoadStatus status, char const *filename) 
+{
+    if (status == LOAD_CANT_OPEN) {
+        putText(out, "Can't open file: ");
+        putLine(out, filename);
+    }
+    else if (status == LOAD_INVALID) {
+        putText(out, "Invalid course file: ");
+        putLine(out, filename);
+    }
+}
+
+/** Helper method to check that the words of a command line that are stored in the
+    command state fit in its buffers.
+    @param *input pointer to the command line.
+    @return true if none of the first COMMAND_WORDS words is longer than MAX_STRING_LEN - 1.
+*/
+static bool wordsFit(char const *input) 
+{
+    char const *pos = input;
+    for (int i = 0; i < COMMAND_WORDS; i++) {
+        pos += strspn(pos, " \t\n\v\f\r");
+        size_t len = strcspn(pos, " \t\n\v\f\r");
+        if (len > MAX_STRING_LEN - 1) {
+            return false;
+        }
+        pos += len;
+    }
+    return true;
+}
+
+/** This function carries out one command, like runCommand(), and tells which kind of
+    command it was so it can be timed.
+    @param *state pointer to the command state.
+    @param *input pointer to the command line.
+    @param *out where to print the results.
+    @param *timer pointer to where the timer for the kind of command is stored.
+    @return false if the command was quit and true otherwise.
+*/
+static bool dispatchCommand(CommandState *state, char *input, Output *out, StatTimer *timer) 
+{
+    // The catalog the commands look courses up in, the newest one there is.
+    refreshCommandState(state);
+    Catalog *catalog = state->snapshot->catalog;
+    
+    // Array to hold user commands.
+    char *command = state->command;
+    char *param1 = state->param1;
+    char *param2 = state->param2;
+    char *param3 = state->param3;
+    
+    // A word too long for its buffer can't be any valid command, so it isn't copied.
+    if (!wordsFit(input)) {
+        putLine(out, input);
+        putText(out, "Invalid command\n");
+        return true;
+    }
+    // Store each of commands from users. The widths are MAX_STRING_LEN - 1.
+    int match = sscanf(input, "%100s %100s %100s %100s", command, param1, param2, param3);
+    
+    // The current student's schedule.
+    Schedule *schedule = sessionSchedule(state->sessions, state->current);
+
+    // If command is list.
+    if (strcmp(command, "list") == 0) {
+        
+        // If command is list courses, print all the courses.
+        if (strcmp(param1, "courses") == 0) {
+            putLine(out, input);
+            *timer = TIMER_LIST_COURSES;
+            if (match != 2) {
+                putText(out, "Invalid command\n");
+                return true;
+            }
+            listCourses(out, catalog->byId, catalog->count, truePointer, 0);
+        }
+        // If the command is list names, print all the courses sorted by names.
+        else if (strcmp(param1, "names") == 0) {
+            putLine(out, input);
+            *timer = TIMER_LIST_NAMES;
+            if (match != 2) {
+                putText(out, "Invalid command\n");
+                return true;
+            }
+            listCourses(out, catalog->byName, catalog->count, truePointer, 0);
+        }
+        // If the command is list department, sort the courses and print all the courses that matches 
+        // the given department field.
+        else if (strcmp(param1, "department") == 0) {
+            putLine(out, input);
+            *timer = TIMER_LIST_DEPARTMENT;
+            if (match != 3) {
+                putText(out, "Invalid command\n");
+                return true;
+            }
+            // If the given department field is not 3 uppercase letters, it is invalid.
+            if (strlen(param2) != DEPARTMENT_CHAR || !isupper(param2[0]) || !isupper(param2[1]) || !isupper(param2[2])) {
+                putText(out, "Invalid command\n");
+                putBytes(out, "\n", 1);
+                return true;
+            }
+            // Only the courses in the department's bucket need to be printed.
+            int count;
+            Course **view = departmentView(catalog, packDepartment(param2), &count);
+            listCourses(out, view, count, truePointer, 0);
+        }
+        // If the command is list timeslot, sort the course by their timeslot and print 
+        // all the courses the matches the given timeslot.
+        else if (strcmp(param1, "timeslot") == 0) {
+            putLine(out, input);
+            *timer = TIMER_LIST_TIMESLOT;
+            // Check to see if it is a valid day.
+            if (match != 4) {
+                putText(out, "Invalid command\n");
+                return true;
+            }
+            if (strcmp(param2, "MW") != 0 && strcmp(param2, "TH") != 0) {
+                putText(out, "Invalid command\n");
+                putBytes(out, "\n", 1);
+                return true;
+            }
+            // Check to see if it is a valid time.
+            if (!isTimesValid(param3)) {
+                putText(out, "Invalid command\n");
+                putBytes(out, "\n", 1);
+                return true;
+            }
+            // Only the courses in the timeslot's bucket need to be printed.
+            int count;
+            Course **view = timeslotView(catalog, packTimeslot(param2, param3), &count);
+            listCourses(out, view, count, truePointer, 0);
+        }
+        // If the command is list schedule, list all the course in the student's schedule.
+        // Should be sorted by days followed by time.
+        else if (strcmp(param1, "schedule") == 0) {
+            putLine(out, input);
+            *timer = TIMER_LIST_SCHEDULE;
+            if (match != 2) {
+                putText(out, "Invalid command\n");
+                return true;
+            }
+            listSchedule(out, schedule);
+        }
+        // If the command is a query, like list where dept=CSC sort name limit 20, list
+        // the courses that match it.
+        else if (isQueryWord(param1)) {
+            putLine(out, input);
+            *timer = TIMER_LIST_QUERY;
+            Query query;
+            if (!parseQuery(input, &query)) {
+                putText(out, "Invalid command\n");
+            }
+            else {
+                runQuery(out, catalog, &query);
+            }
+        }
+        // If the parameter after list is not valid.
+        else {
+            putText(out, command);
+            putBytes(out, " ", 1);
+            putLine(out, param1);
+            putText(out, "Invalid command\n");
+            
+        }
+    }
+    // If the command is add, add course to the schedule.
+    else if (strcmp(command, "add") == 0) {
+        putLine(out, input);
+        *timer = TIMER_ADD;
+        if (match != 3) {
+            putText(out, "Invalid command\n");
+            return true;
+        }
+        addCourse(out, schedule, catalog, param1, param2);
+    }
+    // If the command is drop, drop the course from the schedule.
+    else if(strcmp(command, "drop") == 0) {
+        putLine(out, input);
+        *timer = TIMER_DROP;
+        if (match != 3) {
+            putText(out, "Invalid command\n");
+            return true;
+        }
+        dropCourse(out, schedule, catalog, param1, param2);
+    }
+    // If the command is search, list the courses with the text after it in their name.
+    else if(strcmp(command, "search") == 0) {
+        putLine(out, input);
+        *timer = TIMER_SEARCH;
+        if (match < 2) {
+            putText(out, "Invalid command\n");
+            return true;
+        }
+        if (!searchCourses(out, catalog, strstr(input, command) + strlen(command))) {
+            putText(out, "Invalid command\n");
+        }
+    }
+    // If the command is autoschedule, print the best schedules the student could have
+    // with courses from the wishlist after it.
+    else if(strcmp(command, "autoschedule") == 0) {
+        putLine(out, input);
+        *timer = TIMER_AUTOSCHEDULE;
+        if (!autoschedule(out, schedule, catalog, input)) {
+            putText(out, "Invalid command\n");
+        }
+    }
+    // If the command is student, switch to that student's schedule.
+    else if(strcmp(command, "student") == 0) {
+        putLine(out, input);
+        *timer = TIMER_STUDENT;
+        if (match != 2) {
+            putText(out, "Invalid command\n");
+            return true;
+        }
+        state->current = openSession(state->sessions, param1);
+    }
+    // If the command is calendar, print the calendar for the student's schedule.
+    else if(strcmp(command, "calendar") == 0) {
+        putLine(out, input);
+        *timer = TIMER_CALENDAR;
+        if (match != 1) {
+            putText(out, "Invalid command\n");
+            return true;
+        }
+        printCalendar(out, schedule);
+    }
+    // If the command is reload, read the course files again. Reading them is a job, and
+    // the command is finished once the job is done.
+    else if(strcmp(command, "reload") == 0) {
+        putLine(out, input);
+        *timer = TIMER_RELOAD;
+        if (match != 1) {
+            putText(out, "Invalid command\n");
+            return true;
+        }
+        state->job = JOB_RELOAD;
+        return true;
+    }
+    // If the command is load, add the courses in another course file to the catalog, as
+    // a job like reload.
+    else if(strcmp(command, "load") == 0) {
+        putLine(out, input);
+        *timer = TIMER_LOAD;
+        if (match != 2) {
+            putText(out, "Invalid command\n");
+            return true;
+        }
+        state->job = JOB_LOAD;
+        return true;
+    }
+    // If the command is stats, print what has been counted so far.
+    else if(strcmp(command, "stats") == 0) {
+        putLine(out, input);
+        *timer = TIMER_STATS;
+        if (match != 1) {
+            putText(out, "Invalid command\n");
+            return true;
+        }
+        printStats(out, catalog);
+    }
+    // If the command is quit, this stream of commands is done.
+    else if(strcmp(command, "quit") == 0) {
+        putLine(out, input);
+        *timer = TIMER_QUIT;
+        if (match != 1) {
+            putText(out, "Invalid command\n");
+            return true;
+        }
+        return false;
+    }
+    // The the user did not give one of the valid command, list, search, add, drop,
+    // autoschedule, student, calendar, reload, load, stats or quit.
+    // Print invalid command.
+    else {
+        putText(out, "Invalid command\n");
+    }
+    // Print a new line character.
+    putBytes(out, "\n", 1);
+    
+    return true;
+}
+
+bool runCommand(CommandState *state, char *input, Output *out) 
+{
+    // Each kind of command is timed on its own, and anything that isn't a command counts
+    // as invalid.
+    long start = statsClock();
+    StatTimer timer = TIMER_INVALID;
+    bool more = dispatchCommand(state, input, out, &timer);
+    
+    // A command that left a job is timed once the job is done, which is right away
+    // unless it's handed off to another thread.
+    if (state->job != JOB_NONE) {
+        state->jobStart = start;
+        if (!state->handOff) {
+            char const *failed = NULL;
+            LoadStatus status = runJob(state, &failed);
+            finishJob(state, status, failed, out);
+        }
+        return more;
+    }
+    recordTime(timer, start);
+    return more;
+}
+
+LoadStatus runJob(CommandState *state, char const **failed) 
+{
+    if (state->job == JOB_RELOAD) {
+        return reloadCatalog(state->live, failed);
+    }
+    // The file being loaded is the one blamed if there is a problem.
+    *failed = state->param1;
+    return appendCatalog(state->live, state->param1);
+}
+
+void finishJob(CommandState *state, LoadStatus status, char const *failed, Output *out) 
+{
+    printLoadStatus(out, status, failed);
+    putBytes(out, "\n", 1);
+    recordTime(state->job == JOB_RELOAD ? TIMER_RELOAD : TIMER_LOAD, state->jobStart);
+    state->job = JOB_NONE;
+}
+
+CommandState *makeCommandState(LiveCatalog *live) 
+{
+    // Each student gets their own schedule over the shared catalog. Commands apply to
+    // the current session, which starts out as an unnamed student's.
+    CommandState *state = (CommandState *)calloc(1, sizeof(CommandState));
+    state->live = live;
+    state->snapshot = acquireSnapshot(live);
+    state->sessions = makeSessions();
+    state->current = openSession(state->sessions, "");
+    return state;
+}
+
+void freeCommandState(CommandState *state) 
+{
+    // Free every student's session.
+    freeSessions(state->sessions);
+    releaseSnapshot(state->snapshot);
+    free(state);
+}
+
+void refreshCommandState(CommandState *state) 
+{
+    // Checking is just a load, so this costs nothing until there is a new catalog.
+    if (isCurrent(state->live, state->snapshot)) {
+        return;
+    }
+    // The schedules still point into the old catalog, so it's released after they move.
+    // A catalog that only added courses to the old one shares its courses, so the
+    // schedules can stay as they are.
+    Snapshot *old = state->snapshot;
+    state->snapshot = acquireSnapshot(state->live);
+    if (state->snapshot->lineage != old->lineage) {
+        resolveSessions(state->sessions, state->snapshot->catalog);
+    }
+    releaseSnapshot(old);
+}
+
+void runCommands(LiveCatalog *live, LineReader *reader, Output *out, bool batch) 
+{
+    CommandState *state = makeCommandState(live);
+    
+    // Loop through to keep asking users for commands.
+    while (1) {
+        
+        // User prompt. Someone typing commands needs to see it before we wait for the
+        // next command, but a batch script doesn't. Stop if no one is there to see it.
+        putText(out, "cmd> ");
+        if (!batch && !flushOutput(out)) {
+            break;
+        }
+        // Pointer to the line read on the command line, good until the next line is read.
+        char *input = nextLine(reader, NULL);
+        
+        // Terminate successfully if it reaches EOF while trying to read the next command,
+        // or if the command is quit.
+        if (input == NULL || !runCommand(state, input, out)) {
+            break;
+        }
+    }
+    
+    freeCommandState(state);
+}
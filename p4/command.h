@@ -0,0 +1,103 @@
+/** @file command.h
+    @author Huy Nguyen (hqnguyen)
+    This is the header file for the component that carries out the users commands.
+*/
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdbool.h>
+
+#include "catalog.h"
+#include "student.h"
+#include "output.h"
+#include "input.h"
+#include "snapshot.h"
+
+/** The commands that read course files, which can be left for another thread to do. */
+typedef enum { JOB_NONE, JOB_RELOAD, JOB_LOAD } JobKind;
+
+/** The command state struct holds everything a stream of commands works on: the live
+    catalog the courses come from and the snapshot of it the schedules point into, the
+    students' sessions, and current, the session that add, drop and the other schedule
+    commands apply to. The command and its parameters hold the words of the last command.
+    A command with fewer words than the one before it keeps the left over words, like the
+    transcript always has. Reload and load leave the course files they read to a job,
+    which is run right away unless handOff is set. Then the job is left for another
+    thread to run with runJob(), and the command is finished by finishJob() after that.
+    JobStart is when the command started, so it's timed once it's finished.
+*/
+typedef struct {
+    LiveCatalog *live;
+    Snapshot *snapshot;
+    SessionTable *sessions;
+    int current;
+    char command[MAX_STRING_LEN];
+    char param1[MAX_STRING_LEN];
+    char param2[MAX_STRING_LEN];
+    char param3[MAX_STRING_LEN];
+    
+    bool handOff;
+    JobKind job;
+    long jobStart;
+    
+} CommandState;
+
+/** This function dynamically allocate memory for a command state over the given catalog,
+    with a session table of its own and the unnamed student's session as the current one.
+    @param *live pointer to the live catalog the courses come from.
+    @return a pointer to the new state.
+*/
+CommandState *makeCommandState(LiveCatalog *live);
+
+/** This function free all the memory for the given command state and its sessions, and
+    releases its snapshot of the catalog.
+    @param *state pointer to the state.
+*/
+void freeCommandState(CommandState *state);
+
+/** This function moves the state to the current snapshot of the catalog if a newer one
+    was published, pointing every session's schedule at the new catalog and releasing the
+    old snapshot. It is done before each command, and can be done between commands to
+    let go of an old catalog sooner.
+    @param *state pointer to the state.
+*/
+void refreshCommandState(CommandState *state);
+
+/** This function carries out one command, printing the command and its results to the
+    output the same way the interactive transcript shows them.
+    @param *state pointer to what the command works on.
+    @param *input the command line without the newline.
+    @param *out where to print.
+    @return false if the command was quit, true otherwise.
+*/
+bool runCommand(CommandState *state, char *input, Output *out);
+
+/** This function reads the course files for the reload or load command a state left
+    as its job. It can be run on another thread, as long as the state doesn't run any
+    other command until the job is finished.
+    @param *state pointer to the state whose last command left a job.
+    @param **failed pointer to where the name of the file that had a problem is stored.
+    @return LOAD_OK if the catalog was changed, or what went wrong.
+*/
+LoadStatus runJob(CommandState *state, char const **failed);
+
+/** This function finishes the command that left a job once runJob() is done with it,
+    printing the rest of its results.
+    @param *state pointer to the state.
+    @param status what runJob() returned.
+    @param *failed the file runJob() stored if there was a problem.
+    @param *out where to print.
+*/
+void finishJob(CommandState *state, LoadStatus status, char const *failed, Output *out);
+
+/** This function asks for and carries out commands from the reader until the quit command
+    or the end of the input, with a session table of its own.
+    @param *live pointer to the live catalog the courses come from.
+    @param *reader where to read the commands from.
+    @param *out where to print the prompts, commands and their results.
+    @param batch true to only write the output when the buffer fills, false to write it
+                 before waiting on each command.
+*/
+void runCommands(LiveCatalog *live, LineReader *reader, Output *out, bool batch);
+
+#endif
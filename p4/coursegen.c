@@ -0,0 +1,83 @@
+/** @file coursegen.c
+    @author Huy Nguyen (hqnguyen)
+    This program writes a synthetic course file to standard output, for trying the schedule
+    program on catalogs of any size. With -c it instead writes a script of commands that
+    only names courses in the course file the same options make.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "generate.h"
+
+/** Default number of courses to make up */
+#define DEFAULT_COURSES 1000
+
+/** This function prints the usage message and exits.
+*/
+static void usage()
+{
+    fprintf(stderr, "usage: coursegen [-n courses] [-d departments] [-l min-max] [-s seed] [-c commands]\n");
+    exit(1);
+}
+
+/** Parses the options and writes the course file or the command script.
+    @param argc the number of command-line argument.
+    @param *argv the pointer to each command line argument.
+    @return the exit status.
+*/
+int main(int argc, char *argv[])
+{
+    // The number of courses decides how many departments there are by default, so it's
+    // found first.
+    int courses = DEFAULT_COURSES;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-n") == 0) {
+            courses = atoi(argv[i + 1]);
+        }
+    }
+    CourseMix mix;
+    defaultMix(&mix, courses);
+
+    // Every option has a value after it.
+    int commands = -1;
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 >= argc) {
+            usage();
+        }
+        char const *value = argv[i + 1];
+        if (strcmp(argv[i], "-n") == 0) {
+            continue;
+        }
+        else if (strcmp(argv[i], "-d") == 0) {
+            mix.departments = atoi(value);
+        }
+        else if (strcmp(argv[i], "-l") == 0) {
+            if (sscanf(value, "%d-%d", &mix.minName, &mix.maxName) != 2) {
+                usage();
+            }
+        }
+        else if (strcmp(argv[i], "-s") == 0) {
+            mix.seed = strtoull(value, NULL, 10);
+        }
+        else if (strcmp(argv[i], "-c") == 0 && atoi(value) >= 0) {
+            commands = atoi(value);
+        }
+        else {
+            usage();
+        }
+    }
+    if (!isMixValid(&mix)) {
+        fprintf(stderr, "Invalid course mix\n");
+        exit(1);
+    }
+
+    if (commands >= 0) {
+        writeCommands(stdout, &mix, commands);
+    }
+    else {
+        writeCourses(stdout, &mix);
+    }
+    return fflush(stdout) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
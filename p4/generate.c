@@ -0,0 +1,252 @@
+/** @file generate.c
+    @author Huy Nguyen (hqnguyen)
+    This component contains functions for making up synthetic course files and command
+    scripts of any size, so the schedule program can be benchmarked on big catalogs.
+*/
+
+// Needed for strtok_r() with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "generate.h"
+#include "input.h"
+#include "student.h"
+
+/** Departments are picked this far apart, which has no factor in common with
+    DEPARTMENT_COUNT, so they are all different and spread over the alphabet */
+#define DEPARTMENT_STRIDE 7919
+
+/** Numbers in a department are picked this far apart, which has no factor in common
+    with NUMBERS_PER_DEPARTMENT, so they are all different and out of order */
+#define NUMBER_STRIDE 337
+
+/** Scrambles the seed for the command script, so it isn't tied to the course file */
+#define COMMAND_SEED 0x9e3779b97f4a7c15ULL
+
+/** Commands out of a thousand up to which each kind of command is picked. Listing the
+    whole catalog is kept rare, or it would be all a script for a big catalog does. */
+#define ADD_PER_MILLE 300
+#define DROP_PER_MILLE 550
+#define LIST_SCHEDULE_PER_MILLE 650
+#define CALENDAR_PER_MILLE 730
+#define DEPARTMENT_PER_MILLE 820
+#define TIMESLOT_PER_MILLE 920
+#define STUDENT_PER_MILLE 988
+#define LIST_COURSES_PER_MILLE 989
+#define LIST_NAMES_PER_MILLE 990
+
+/** Number of students the command script switches between */
+#define STUDENTS 8
+
+/** The days a course can meet. */
+static char const *validDays[NUMBER_OF_VALID_DAYS] = {"MW", "TH"};
+
+/** The times a course can start. */
+static char const *validTimes[NUMBER_OF_VALID_TIME] = {"8:30", "10:00", "11:30", "1:00", "2:30", "4:00"};
+
+/** The whitespace between fields, mostly single spaces like the hand written files. */
+static char const *separators[] = {" ", " ", " ", "  ", "\t", " \t "};
+
+/** The words course names are made of. */
+static char const *words[] = {
+    "Intro", "to", "Data", "Structures", "Calculus", "Linear", "Algebra", "French",
+    "Design", "Theory", "Writing", "Technical", "Advanced", "Topics", "in", "Systems",
+    "Software", "Engineering", "Organic", "Chemistry", "Forestry", "Management", "of",
+    "the", "Applied", "Statistics", "Zoology", "Crop", "Rotation", "Video", "Production"
+};
+
+/** Helper method to get the next number from a seeded random sequence. It's a splitmix64
+    generator, so the same seed makes the same files on every machine.
+    @param *state pointer to the state of the sequence.
+    @return the next number.
+*/
+static uint64_t nextRandom(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/** Helper method to pick a random number from 0 up to but not including n.
+    @param *state pointer to the state of the sequence.
+    @param n how many numbers to pick from.
+    @return the number.
+*/
+static int pick(uint64_t *state, int n)
+{
+    return (int)(nextRandom(state) % (uint64_t)n);
+}
+
+void defaultMix(CourseMix *mix, int courses)
+{
+    mix->courses = courses;
+    mix->departments = DEFAULT_DEPARTMENTS;
+    while ((long)mix->departments * NUMBERS_PER_DEPARTMENT < courses && mix->departments < DEPARTMENT_COUNT) {
+        mix->departments *= DOUBLE_ARRAY;
+    }
+    if (mix->departments > DEPARTMENT_COUNT) {
+        mix->departments = DEPARTMENT_COUNT;
+    }
+    mix->minName = DEFAULT_MIN_NAME;
+    mix->maxName = DEFAULT_MAX_NAME;
+    mix->seed = 1;
+}
+
+bool isMixValid(CourseMix const *mix)
+{
+    return mix->courses >= 0 && mix->departments > 0 && mix->departments <= DEPARTMENT_COUNT &&
+           (long)mix->departments * NUMBERS_PER_DEPARTMENT >= mix->courses &&
+           mix->minName > 0 && mix->minName <= mix->maxName && mix->maxName <= NAME_LETTERS;
+}
+
+void courseName(CourseMix const *mix, int k, char dept[DEPARTMENT_LEN], char number[NUMBER_LEN])
+{
+    // Departments take turns, so each one gets every departments-th course.
+    int d = k % mix->departments;
+    int n = k / mix->departments;
+
+    // Turn the department into three letters, starting somewhere that depends on the seed.
+    int code = (int)((d * (long)DEPARTMENT_STRIDE + mix->seed) % DEPARTMENT_COUNT);
+    for (int i = DEPARTMENT_LETTERS - 1; i >= 0; i--) {
+        dept[i] = 'A' + code % 26;
+        code /= 26;
+    }
+    dept[DEPARTMENT_LETTERS] = '\0';
+
+    // Departments start at different numbers, so they don't all look alike.
+    int value = (n * NUMBER_STRIDE + d) % NUMBERS_PER_DEPARTMENT;
+    for (int i = NUMBER_LETTERS - 1; i >= 0; i--) {
+        number[i] = '0' + value % 10;
+        value /= 10;
+    }
+    number[NUMBER_LETTERS] = '\0';
+}
+
+/** Helper method to make up a course name between the shortest and longest name
+    lengths of the mix, out of whole words with the last one cut short to fit.
+    @param *mix pointer to the mix.
+    @param *state pointer to the state of the random sequence.
+    @param *name pointer to where the name is stored, with room for NAME_LEN.
+*/
+static void makeName(CourseMix const *mix, uint64_t *state, char name[NAME_LEN])
+{
+    int target = mix->minName + pick(state, mix->maxName - mix->minName + 1);
+    int len = 0;
+
+    // A word after the first needs room for a space and at least one letter.
+    while (len == 0 || len + 1 < target) {
+        if (len > 0) {
+            name[len++] = ' ';
+        }
+        char const *word = words[pick(state, sizeof(words) / sizeof(words[0]))];
+        int n = strlen(word);
+        if (n > target - len) {
+            n = target - len;
+        }
+        memcpy(name + len, word, n);
+        len += n;
+    }
+    name[len] = '\0';
+}
+
+/** Helper method to pick the whitespace between two fields.
+    @param *state pointer to the state of the random sequence.
+    @return the whitespace.
+*/
+static char const *separator(uint64_t *state)
+{
+    return separators[pick(state, sizeof(separators) / sizeof(separators[0]))];
+}
+
+void writeCourses(FILE *fp, CourseMix const *mix)
+{
+    uint64_t state = mix->seed;
+    for (int k = 0; k < mix->courses; k++) {
+        char dept[DEPARTMENT_LEN];
+        char number[NUMBER_LEN];
+        courseName(mix, k, dept, number);
+        fprintf(fp, "%s%s%s%s", dept, separator(&state), number, separator(&state));
+        fprintf(fp, "%s%s", validDays[pick(&state, NUMBER_OF_VALID_DAYS)], separator(&state));
+        fprintf(fp, "%s%s", validTimes[pick(&state, NUMBER_OF_VALID_TIME)], separator(&state));
+
+        // The words of the name can be split by any whitespace, it reads back the same.
+        char name[NAME_LEN];
+        makeName(mix, &state, name);
+        char *rest;
+        for (char *word = strtok_r(name, " ", &rest); word != NULL; word = strtok_r(NULL, " ", &rest)) {
+            fprintf(fp, "%s%s", word == name ? "" : separator(&state), word);
+        }
+        fputc('\n', fp);
+    }
+}
+
+void writeCommands(FILE *fp, CourseMix const *mix, int count)
+{
+    uint64_t state = mix->seed ^ COMMAND_SEED;
+    char dept[DEPARTMENT_LEN];
+    char number[NUMBER_LEN];
+    
+    // Drops mostly name a course the current student added and hasn't dropped yet, so
+    // they have something to drop. The student before the first student command is the
+    // last one. A student with a schedule's worth drops one before adding another, so
+    // every course in a schedule is one the script can still drop.
+    int added[STUDENTS + 1][SCHEDULE_MAX_LEN];
+    int addCount[STUDENTS + 1] = { 0 };
+    int student = STUDENTS;
+    for (int i = 0; i < count; i++) {
+        int perMille = pick(&state, 1000);
+        int *courses = added[student];
+        int *n = &addCount[student];
+
+        // Adds and drops name a course in the catalog, if there are any.
+        if (perMille < ADD_PER_MILLE && mix->courses > 0 && *n < SCHEDULE_MAX_LEN) {
+            int k = pick(&state, mix->courses);
+            courses[(*n)++] = k;
+            courseName(mix, k, dept, number);
+            fprintf(fp, "add %s %s\n", dept, number);
+        }
+        else if (perMille < DROP_PER_MILLE && mix->courses > 0) {
+            int k = pick(&state, mix->courses);
+            if (*n > 0) {
+                int j = pick(&state, *n);
+                k = courses[j];
+                courses[j] = courses[--(*n)];
+            }
+            courseName(mix, k, dept, number);
+            fprintf(fp, "drop %s %s\n", dept, number);
+        }
+        else if (perMille < LIST_SCHEDULE_PER_MILLE) {
+            fprintf(fp, "list schedule\n");
+        }
+        else if (perMille < CALENDAR_PER_MILLE) {
+            fprintf(fp, "calendar\n");
+        }
+        else if (perMille < DEPARTMENT_PER_MILLE && mix->courses > 0) {
+            courseName(mix, pick(&state, mix->courses), dept, number);
+            fprintf(fp, "list department %s\n", dept);
+        }
+        else if (perMille < TIMESLOT_PER_MILLE) {
+            fprintf(fp, "list timeslot %s %s\n", validDays[pick(&state, NUMBER_OF_VALID_DAYS)],
+                    validTimes[pick(&state, NUMBER_OF_VALID_TIME)]);
+        }
+        else if (perMille < STUDENT_PER_MILLE) {
+            student = pick(&state, STUDENTS);
+            fprintf(fp, "student s%d\n", student);
+        }
+        else if (perMille < LIST_COURSES_PER_MILLE) {
+            fprintf(fp, "list courses\n");
+        }
+        else if (perMille < LIST_NAMES_PER_MILLE) {
+            fprintf(fp, "list names\n");
+        }
+        else {
+            // A course number that can't be in any catalog.
+            fprintf(fp, "add ZZZ 1000\n");
+        }
+    }
+    fprintf(fp, "quit\n");
+}
@@ -0,0 +1,78 @@
+/** @file generate.h
+    @author Huy Nguyen (hqnguyen)
+    This is the header file for the component that makes up synthetic course files and
+    command scripts, for benchmarking the schedule program on catalogs of any size.
+*/
+#ifndef GENERATE_H
+#define GENERATE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "catalog.h"
+
+/** Default number of departments the courses are spread over */
+#define DEFAULT_DEPARTMENTS 100
+
+/** Default shortest course name */
+#define DEFAULT_MIN_NAME 4
+
+/** Default longest course name */
+#define DEFAULT_MAX_NAME NAME_LETTERS
+
+/** The mix struct describes the catalog to make up. Courses are spread evenly over
+    departments, which can each hold NUMBERS_PER_DEPARTMENT of them, and names are
+    between minName and maxName letters long. The same mix and seed always make the
+    same catalog, so a command script made from a mix only names courses in the course
+    file made from it.
+*/
+typedef struct {
+    int courses;
+    int departments;
+    int minName;
+    int maxName;
+    uint64_t seed;
+
+} CourseMix;
+
+/** This function fills in a mix with the defaults for the given number of courses,
+    using as many more departments as it takes to hold them.
+    @param *mix pointer to the mix.
+    @param courses the number of courses.
+*/
+void defaultMix( CourseMix *mix, int courses );
+
+/** This function checks whether a mix describes a catalog that can be made.
+    @param *mix pointer to the mix.
+    @return true if the courses fit in the departments and the name lengths are valid.
+*/
+bool isMixValid( CourseMix const *mix );
+
+/** This function makes up the department and number of a course in the mix. Course k of
+    the catalog always gets the same ones, and no two courses get the same.
+    @param *mix pointer to the mix.
+    @param k which course, from 0 up to the number of courses in the mix.
+    @param *dept pointer to where the department is stored.
+    @param *number pointer to where the number is stored.
+*/
+void courseName( CourseMix const *mix, int k, char dept[ DEPARTMENT_LEN ], char number[ NUMBER_LEN ] );
+
+/** This function writes a valid course file for the mix. Courses are written with
+    departments taking turns, so the file is far from sorted, and with the same kinds of
+    extra whitespace as the hand written course files.
+    @param *fp the file to write to.
+    @param *mix pointer to the mix.
+*/
+void writeCourses( FILE *fp, CourseMix const *mix );
+
+/** This function writes a script of commands for a catalog made from the mix. Most are
+    adds and drops of courses in the catalog, with lists, calendars and students mixed in,
+    and the script ends with quit.
+    @param *fp the file to write to.
+    @param *mix pointer to the mix.
+    @param count the number of commands before quit.
+*/
+void writeCommands( FILE *fp, CourseMix const *mix, int count );
+
+#endif
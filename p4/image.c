@@ -0,0 +1,333 @@
+/** @file image.c
+    @author Huy Nguyen (hqnguyen)
+    This component contains functions for saving a catalog as a compiled binary image and
+    loading it back again, so text course files don't have to be parsed on every run.
+*/
+
+// Needed for open(), close() and mmap() with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "image.h"
+#include "stats.h"
+
+/** The header struct is at the start of every image. It says how many courses there are
+    and where each of the arrays after it start, as byte offsets from the start of the
+    image. The courses are stored in course id order, so they are also the byId view.
+*/
+typedef struct {
+    char magic[IMAGE_MAGIC_LEN];
+    int32_t version;
+    int32_t courseSize;
+    int32_t count;
+    int32_t indexCapacity;
+    int32_t slotStart[TIMESLOT_COUNT + 1];
+    
+    uint64_t coursesOffset;
+    uint64_t byNameOffset;
+    uint64_t bySlotOffset;
+    uint64_t deptStartOffset;
+    uint64_t indexOffset;
+    uint64_t gramStartOffset;
+    uint64_t byGramOffset;
+    uint64_t size;
+    
+} ImageHeader;
+
+/** Helper method to find where a course is in the catalog's byId view, which is also
+    where it is in the image's records.
+    @param *catalog pointer to the catalog.
+    @param *course pointer to the course.
+    @return the position of the course in byId.
+*/
+static int32_t positionOf(Catalog const *catalog, Course const *course) 
+{
+    // Binary search, since byId is sorted by id.
+    int low = 0;
+    int high = catalog->count - 1;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (catalog->byId[mid]->id < course->id) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/** Helper method to write a view of the catalog as the positions of its courses.
+    @param *fp pointer to the image file.
+    @param *catalog pointer to the catalog.
+    @param *view array of pointers to courses in the catalog.
+    @param count the number of courses in the view.
+*/
+static void writeView(FILE *fp, Catalog const *catalog, Course * const *view, int count) 
+{
+    for (int i = 0; i < count; i++) {
+        int32_t pos = view[i] == NULL ? -1 : positionOf(catalog, view[i]);
+        fwrite(&pos, sizeof(pos), 1, fp);
+    }
+}
+
+bool writeImage( Catalog const *catalog, char const *filename ) 
+{
+    // Work out where each array goes, one after another after the header.
+    ImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IMAGE_MAGIC, IMAGE_MAGIC_LEN);
+    header.version = IMAGE_VERSION;
+    header.courseSize = sizeof(Course);
+    header.count = catalog->count;
+    header.indexCapacity = catalog->indexCapacity;
+    for (int s = 0; s <= TIMESLOT_COUNT; s++) {
+        header.slotStart[s] = catalog->slotStart[s];
+    }
+    header.coursesOffset = sizeof(ImageHeader);
+    header.byNameOffset = header.coursesOffset + (uint64_t) catalog->count * sizeof(Course);
+    header.bySlotOffset = header.byNameOffset + (uint64_t) catalog->count * sizeof(int32_t);
+    header.deptStartOffset = header.bySlotOffset + (uint64_t) catalog->count * sizeof(int32_t);
+    header.indexOffset = header.deptStartOffset + (DEPARTMENT_COUNT + 1) * sizeof(int32_t);
+    header.gramStartOffset = header.indexOffset + (uint64_t) catalog->indexCapacity * sizeof(int32_t);
+    header.byGramOffset = header.gramStartOffset + (TRIGRAM_BUCKETS + 1) * sizeof(int32_t);
+    
+    // The trigram index holds positions in the list, which for a loaded image is in
+    // course id order, so it's indexed again in that order.
+    int *gramStart = (int *) malloc((TRIGRAM_BUCKETS + 1) * sizeof(int));
+    int *byGram = indexTrigrams(catalog->byId, catalog->count, 0, gramStart);
+    header.size = header.byGramOffset + (uint64_t) gramStart[TRIGRAM_BUCKETS] * sizeof(int32_t);
+    
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        free(gramStart);
+        free(byGram);
+        return false;
+    }
+    fwrite(&header, sizeof(header), 1, fp);
+    
+    // The courses themselves, in course id order.
+    for (int i = 0; i < catalog->count; i++) {
+        fwrite(catalog->byId[i], sizeof(Course), 1, fp);
+    }
+    
+    // The views and indexes, as positions in the courses.
+    writeView(fp, catalog, catalog->byName, catalog->count);
+    writeView(fp, catalog, catalog->bySlot, catalog->count);
+    for (int d = 0; d <= DEPARTMENT_COUNT; d++) {
+        int32_t start = catalog->deptStart[d];
+        fwrite(&start, sizeof(start), 1, fp);
+    }
+    writeView(fp, catalog, catalog->index, catalog->indexCapacity);
+    fwrite(gramStart, sizeof(int32_t), TRIGRAM_BUCKETS + 1, fp);
+    fwrite(byGram, sizeof(int32_t), gramStart[TRIGRAM_BUCKETS], fp);
+    free(gramStart);
+    free(byGram);
+    
+    // Check that every write worked.
+    bool ok = !ferror(fp);
+    return fclose(fp) == 0 && ok;
+}
+
+/** Helper method to check that an array of count items, each width bytes, starts at a
+    whole int32_t offset and fits in the image.
+    @param offset the byte offset of the array from the start of the image.
+    @param count the number of items in the array.
+    @param width the number of bytes in each item.
+    @param size the number of bytes in the image.
+    @return true if the array is inside the image.
+*/
+static bool fits(uint64_t offset, uint64_t count, uint64_t width, uint64_t size) 
+{
+    return offset % sizeof(int32_t) == 0 && offset <= size && count <= (size - offset) / width;
+}
+
+/** Helper method to check the starts of the buckets of an index. They start at 0, never
+    go down and end at the number of items in the index.
+    @param *start array of buckets + 1 starts.
+    @param buckets the number of buckets.
+    @param total the number of items in the index.
+    @return true if the starts are valid.
+*/
+static bool validStarts(int32_t const *start, int buckets, int total) 
+{
+    if (start[0] != 0 || start[buckets] != total) {
+        return false;
+    }
+    for (int b = 0; b < buckets; b++) {
+        if (start[b] > start[b + 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Helper method to check that a course from an image can be used as is. Its packed id
+    and timeslot are used to index arrays and its fields are printed as strings, so they
+    have to be in range and null terminated.
+    @param *course pointer to the course.
+    @return true if the course is valid.
+*/
+static bool validCourse(Course const *course) 
+{
+    return course->id >= 0 && course->id < DEPARTMENT_COUNT * NUMBERS_PER_DEPARTMENT &&
+           course->slot >= 0 && course->slot < TIMESLOT_COUNT &&
+           memchr(course->dept, '\0', DEPARTMENT_LEN) && memchr(course->number, '\0', NUMBER_LEN) &&
+           memchr(course->days, '\0', DAYS_LEN) && memchr(course->time, '\0', TIME_LEN) &&
+           memchr(course->name, '\0', NAME_LEN);
+}
+
+/** Helper method to check the counts and offsets in an image's header, the starts of its
+    indexes and its courses, so a damaged or hand edited image can't make the catalog
+    read outside the mapping. The positions in the views are checked as they're read.
+    @param *header pointer to the header at the start of the image.
+    @param *data pointer to the mapped image.
+    @param size the number of bytes in the image.
+    @return true if the image is safe to use.
+*/
+static bool checkImage(ImageHeader const *header, char const *data, uint64_t size) 
+{
+    // The counts and where each array is have to make sense before any array is read.
+    int count = header->count;
+    int capacity = header->indexCapacity;
+    if (count < 0 || capacity <= count || (capacity & (capacity - 1)) != 0 ||
+        !fits(header->coursesOffset, count, sizeof(Course), size) ||
+        !fits(header->byNameOffset, count, sizeof(int32_t), size) ||
+        !fits(header->bySlotOffset, count, sizeof(int32_t), size) ||
+        !fits(header->deptStartOffset, DEPARTMENT_COUNT + 1, sizeof(int32_t), size) ||
+        !fits(header->indexOffset, capacity, sizeof(int32_t), size) ||
+        !fits(header->gramStartOffset, TRIGRAM_BUCKETS + 1, sizeof(int32_t), size)) {
+        return false;
+    }
+    int32_t const *gramStart = (int32_t const *) (data + header->gramStartOffset);
+    int grams = gramStart[TRIGRAM_BUCKETS];
+    if (!validStarts(header->slotStart, TIMESLOT_COUNT, count) ||
+        !validStarts((int32_t const *) (data + header->deptStartOffset), DEPARTMENT_COUNT, count) ||
+        !validStarts(gramStart, TRIGRAM_BUCKETS, grams) ||
+        !fits(header->byGramOffset, grams, sizeof(int32_t), size)) {
+        return false;
+    }
+    
+    // Then every course has to be one the catalog can use.
+    Course const *courses = (Course const *) (data + header->coursesOffset);
+    for (int i = 0; i < count; i++) {
+        if (!validCourse(&courses[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Helper method to turn an array of course positions from an image into pointers,
+    checking each position on the way.
+    @param *courses pointer to the courses in the image.
+    @param total the number of courses in the image.
+    @param *positions the positions of the courses, -1 for no course.
+    @param count the number of positions.
+    @param *named pointer to where the number of positions that aren't -1 is stored, or
+    -1 if a position isn't a course.
+    @return a dynamically allocated array of pointers to the courses.
+*/
+static Course **readView(Course *courses, int total, int32_t const *positions, int count, int *named) 
+{
+    Course **view = (Course **) malloc((count + 1) * sizeof(Course *));
+    bool valid = true;
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        int32_t pos = positions[i];
+        valid = valid && pos >= -1 && pos < total;
+        n += pos >= 0;
+        view[i] = pos < 0 || !valid ? NULL : &courses[pos];
+    }
+    *named = valid ? n : -1;
+    return view;
+}
+
+Catalog *loadImage( char const *filename ) 
+{
+    long start = statsClock();
+    
+    // Open the file and map all of it.
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size < (off_t) sizeof(ImageHeader)) {
+        close(fd);
+        return NULL;
+    }
+    char *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    
+    // Check that this is an image with the same layout this program uses.
+    ImageHeader const *header = (ImageHeader const *) data;
+    if (memcmp(header->magic, IMAGE_MAGIC, IMAGE_MAGIC_LEN) != 0 || header->version != IMAGE_VERSION || 
+        header->courseSize != sizeof(Course) || header->size != (uint64_t) info.st_size ||
+        !checkImage(header, data, info.st_size)) {
+        munmap(data, info.st_size);
+        return NULL;
+    }
+    
+    // Dynamically allocate memory for catalog, whose courses stay in the image.
+    Catalog *catalog = (Catalog *) malloc(sizeof(Catalog));
+    Course *courses = (Course *) (data + header->coursesOffset);
+    catalog->count = header->count;
+    catalog->capacity = header->count + STARTING_CAPACITY;
+    catalog->blocks = NULL;
+    adoptMapping(catalog, data, info.st_size);
+    
+    // The courses are in course id order, so they are the byId view and the list.
+    catalog->byId = (Course **) malloc((catalog->count + 1) * sizeof(Course *));
+    for (int i = 0; i < catalog->count; i++) {
+        catalog->byId[i] = &courses[i];
+    }
+    catalog->list = (Course **) malloc(catalog->capacity * sizeof(Course *));
+    memcpy(catalog->list, catalog->byId, catalog->count * sizeof(Course *));
+    
+    // Turn the rest of the views and indexes back into pointers. Every course is in the
+    // hash index once, and the other views name a course everywhere.
+    int named[3];
+    catalog->byName = readView(courses, catalog->count, (int32_t const *) (data + header->byNameOffset), catalog->count, &named[0]);
+    catalog->bySlot = readView(courses, catalog->count, (int32_t const *) (data + header->bySlotOffset), catalog->count, &named[1]);
+    catalog->indexCapacity = header->indexCapacity;
+    catalog->index = readView(courses, catalog->count, (int32_t const *) (data + header->indexOffset), catalog->indexCapacity, &named[2]);
+    catalog->deptStart = (int *) malloc((DEPARTMENT_COUNT + 1) * sizeof(int));
+    memcpy(catalog->deptStart, data + header->deptStartOffset, (DEPARTMENT_COUNT + 1) * sizeof(int));
+    for (int s = 0; s <= TIMESLOT_COUNT; s++) {
+        catalog->slotStart[s] = header->slotStart[s];
+    }
+    catalog->gramStart = (int *) malloc((TRIGRAM_BUCKETS + 1) * sizeof(int));
+    memcpy(catalog->gramStart, data + header->gramStartOffset, (TRIGRAM_BUCKETS + 1) * sizeof(int));
+    int grams = catalog->gramStart[TRIGRAM_BUCKETS];
+    int32_t const *byGram = (int32_t const *) (data + header->byGramOffset);
+    catalog->byGram = (int *) malloc((grams + 1) * sizeof(int));
+    bool valid = named[0] == catalog->count && named[1] == catalog->count && named[2] == catalog->count;
+    for (int i = 0; i < grams; i++) {
+        valid = valid && byGram[i] >= 0 && byGram[i] < catalog->count;
+        catalog->byGram[i] = byGram[i];
+    }
+    if (!valid) {
+        freeCatalog(catalog);
+        return NULL;
+    }
+    
+    // An image is ready as soon as it's mapped, so that's all reading it.
+    if (start != 0) {
+        long nanos[LOAD_PHASES] = { 0 };
+        nanos[PHASE_READ] = statsNow() - start;
+        recordLoad(filename, catalog->count, nanos);
+    }
+    return catalog;
+}
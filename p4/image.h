@@ -0,0 +1,43 @@
+/** @file image.h
+    @author Huy Nguyen (hqnguyen)
+    This is the header file for the component that saves a catalog as a compiled binary
+    image and loads it back again.
+*/
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stdbool.h>
+
+#include "catalog.h"
+
+/** Number of bytes in the magic string at the start of every image */
+#define IMAGE_MAGIC_LEN 8
+
+/** The magic string at the start of every image. It starts with a null character, so an
+    image can never be mistaken for a valid course file. */
+#define IMAGE_MAGIC "\0SCHDCAT"
+
+/** Version of the image format, which changes whenever the layout of an image changes */
+#define IMAGE_VERSION 3
+
+/** This function save a catalog as a compiled image. The image holds the courses as
+    fixed-width records in course id order, followed by the name view, the timeslot index,
+    the department index, the hash index and the name trigram index, all as positions of
+    courses in the records.
+    @param *catalog pointer to the catalog, its views must already be built.
+    @param *filename pointer to the name of the image file to write.
+    @return true if the image was written and false otherwise.
+*/
+bool writeImage( Catalog const *catalog, char const *filename );
+
+/** This function load a catalog from a compiled image. The image is mapped into memory
+    with a single mmap and the courses are used right where they are. The views and
+    indexes are turned back into pointers in one pass, and everything the catalog relies
+    on is checked on the way, so a damaged image is turned away instead of read from.
+    @param *filename pointer to the name of the image file.
+    @return a pointer to the new catalog, or NULL if the file can't be opened or isn't a
+    valid image written by this version of the program.
+*/
+Catalog *loadImage( char const *filename );
+
+#endif
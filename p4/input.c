@@ -3,53 +3,113 @@
     This component contains function reading line from input file.
 */
 
+// Needed for read() and EINTR with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
 #include "input.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
 
-char *readLine(FILE *fp) 
+LineReader *makeReader(int fd) 
 {
-    int capacity = INITIAL_CAPACITY;
-    int pos = 0;
-    // Dynamically allocate memory for the line pointer.
-    char *line = (char *)malloc(capacity * sizeof(char));
-
-    // Loop through to read each character in a line of the file.
-    while (1) {
-        int ch = fgetc(fp);
-        if (ch == EOF) {
-            // Check for empty file.
-            if (pos == 0) {
-                free(line);
-                return NULL;
-            } 
-            // Break out of loop if end of file is reached.
-            else {
-                break;
-            }
-        }
-        // Break out of the loop if a new line character is read or end of line.
-        if (ch == '\n') {
-            break;
-        }
-        // Assign the character read to the line string.
-        line[pos++] = ch;
-        
-        // Resizable array to read line that could be arbitrarily large.
-        if (pos >= capacity) {
-            capacity *= DOUBLE_ARRAY;
-            void *temp = (char *)realloc(line, capacity * sizeof(char));
-            if (temp == NULL) {
-                free(line); 
-            } 
-            else {
-                line = temp;
-            }
+    return makeSizedReader(fd, READ_BLOCK);
+}
+
+LineReader *makeSizedReader(int fd, int capacity) 
+{
+    // Dynamically allocate memory for the reader and its first block.
+    LineReader *reader = (LineReader *)malloc(sizeof(LineReader));
+    reader->fd = fd;
+    reader->capacity = capacity;
+    reader->buffer = (char *)malloc(reader->capacity);
+    reader->start = 0;
+    reader->end = 0;
+    reader->searched = 0;
+    reader->eof = false;
+    return reader;
+}
+
+void freeReader(LineReader *reader) 
+{
+    free(reader->buffer);
+    free(reader);
+}
+
+int fillReader(LineReader *reader) 
+{
+    // Move the partial line to the front to make room after it.
+    int unread = reader->end - reader->start;
+    memmove(reader->buffer, reader->buffer + reader->start, unread);
+    reader->start = 0;
+    reader->end = unread;
+    
+    // Resizable buffer for a line that could be arbitrarily large, always leaving
+    // room for a null character after the last byte.
+    if (reader->end >= reader->capacity - 1) {
+        reader->capacity *= DOUBLE_ARRAY;
+        reader->buffer = (char *)realloc(reader->buffer, reader->capacity);
+    }
+    
+    // Read as much as is available, retrying if a signal interrupts the read.
+    int n;
+    do {
+        n = read(reader->fd, reader->buffer + reader->end, reader->capacity - reader->end - 1);
+    } while (n < 0 && errno == EINTR);
+    
+    // A file that isn't ready yet just hasn't got more bytes for now.
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return -1;
+    }
+    // A read error ends the input the same way the end of the file does.
+    if (n <= 0) {
+        reader->eof = true;
+        return 0;
+    }
+    reader->end += n;
+    return n;
+}
+
+char *bufferedLine(LineReader *reader, int *len) 
+{
+    // Search the unread bytes for a newline, skipping the ones already searched.
+    char *newline = memchr(reader->buffer + reader->start + reader->searched, '\n', 
+                           reader->end - reader->start - reader->searched);
+    if (newline == NULL) {
+        // A partial line is only a line once the file ends without finishing it.
+        if (!reader->eof || reader->start == reader->end) {
+            reader->searched = reader->end - reader->start;
+            return NULL;
         }
-        
+        // The last line has no newline, so end it at the end of the file.
+        newline = reader->buffer + reader->end;
+    }
+    
+    // Replace the newline with a null character and hand out the line.
+    char *line = reader->buffer + reader->start;
+    *newline = '\0';
+    if (len != NULL) {
+        *len = newline - line;
+    }
+    // Skip over the newline, unless the line ended at the end of the file.
+    if (newline == reader->buffer + reader->end) {
+        reader->start = reader->end;
+    }
+    else {
+        reader->start = newline - reader->buffer + 1;
+    }
+    reader->searched = 0;
+    return line;
+}
+
+char *nextLine(LineReader *reader, int *len) 
+{
+    // Read more until a whole line shows up, or the file ends.
+    char *line;
+    while ((line = bufferedLine(reader, len)) == NULL && !reader->eof) {
+        fillReader(reader);
     }
-    // Add a null character.
-    line[pos] = '\0';
-    // Return the line pointer.
     return line;
 }
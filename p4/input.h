@@ -2,8 +2,11 @@
     @author Huy Nguyen (hqnguyen)
     This is the header file for the components that read line.
 */
+#ifndef INPUT_H
+#define INPUT_H
 
 #include <stdio.h>
+#include <stdbool.h>
 
 /** Number to multiply by to resize the resizable array */
 #define DOUBLE_ARRAY 2
@@ -11,9 +14,68 @@
 /** The initial capacity of string length. */
 #define INITIAL_CAPACITY 100
 
-/** This function reads a single line of input from the input stream and return a 
-    string in a dynamically allocated block of memory.
-    @param *fp the pointer to the file.
-    @return a pointer to a dynamically allocated memory.
+/** Number of bytes a LineReader asks for from its file with each read */
+#define READ_BLOCK 65536
+
+/** The line reader struct reads its file a large block at a time into buffer and hands
+    out the lines in the buffer one by one. The bytes from start up to end have been
+    read but not handed out yet, and the first searched of them are known not to hold a
+    newline. Capacity is the size of the buffer, which grows if a line doesn't fit, and
+    eof is set once the file has no more bytes.
+*/
+typedef struct {
+    int fd;
+    char *buffer;
+    int capacity;
+    int start;
+    int end;
+    int searched;
+    bool eof;
+    
+} LineReader;
+
+/** This function dynamically allocate memory for a LineReader and its buffer.
+    @param fd the file descriptor to read lines from, it is not closed by the reader.
+    @return a pointer to the new reader.
+*/
+LineReader *makeReader(int fd);
+
+/** This function dynamically allocate memory for a LineReader with a buffer of the given
+    size, for readers that are mostly idle and only ever see short lines.
+    @param fd the file descriptor to read lines from, it is not closed by the reader.
+    @param capacity the starting size of the buffer, which grows if a line doesn't fit.
+    @return a pointer to the new reader.
+*/
+LineReader *makeSizedReader(int fd, int capacity);
+
+/** This function free all the memory for the given LineReader.
+    @param *reader pointer to the reader.
 */
-char *readLine(FILE *fp);
+void freeReader(LineReader *reader);
+
+/** This function hands out the next line from the reader without the newline. The line
+    is stored in the reader's buffer, so it is only good until the next call.
+    @param *reader pointer to the reader.
+    @param *len pointer to where the length of the line is stored, or NULL.
+    @return a pointer to the line, or NULL at the end of the file.
+*/
+char *nextLine(LineReader *reader, int *len);
+
+/** This function does one read from the reader's file into its buffer, after the bytes
+    that haven't been handed out yet. It works on a non-blocking file too.
+    @param *reader pointer to the reader.
+    @return the number of bytes read, 0 at the end of the file, or -1 if the file had no
+            bytes ready.
+*/
+int fillReader(LineReader *reader);
+
+/** This function hands out the next line already in the reader's buffer without the
+    newline, without reading. At the end of the file, a last line without a newline is
+    handed out too. The line is only good until the next call.
+    @param *reader pointer to the reader.
+    @param *len pointer to where the length of the line is stored, or NULL.
+    @return a pointer to the line, or NULL if there isn't a whole line in the buffer.
+*/
+char *bufferedLine(LineReader *reader, int *len);
+
+#endif
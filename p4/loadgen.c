@@ -0,0 +1,452 @@
+/** @file loadgen.c
+    @author Huy Nguyen (hqnguyen)
+    This is a load generator for schedule --serve. It holds a number of idle clients open,
+    measures how fast clients can connect, run a command and quit, and measures the
+    latency of commands on busy clients. With -r it instead replays a script of commands
+    over one connection and prints the transcript, to check it against a normal run.
+*/
+
+// Needed for sockets, poll() and clock_gettime() with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+
+/** The prompt the server prints when it is ready for the next command */
+#define PROMPT "cmd> "
+
+/** Length of the prompt */
+#define PROMPT_LEN 5
+
+/** Size of the buffer responses are read into */
+#define RESPONSE_BLOCK 65536
+
+/** Default number of threads making clients busy */
+#define DEFAULT_THREADS 4
+
+/** Default number of clients that connect, run a command and quit */
+#define DEFAULT_CONNECTS 1000
+
+/** Default number of commands each busy thread sends */
+#define DEFAULT_COMMANDS 10000
+
+/** Nanoseconds in a second */
+#define NANOS 1000000000LL
+
+/** Nanoseconds in a microsecond */
+#define NANOS_PER_MICRO 1000
+
+/** Percent of the latencies that are at most the 99th percentile */
+#define P99 99
+
+/** Percent of the latencies that are at most the median */
+#define P50 50
+
+/** The commands busy clients send, round and round. */
+static char const *commands[] = {
+    "list schedule\n",
+    "add CSC 116\n",
+    "calendar\n",
+    "drop CSC 116\n",
+    "list department CSC\n",
+};
+
+/** Number of different commands busy clients send */
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+
+/** The socket address of the server, shared by every thread. */
+static struct sockaddr_un addr;
+
+/** The worker struct is one thread of the test and what it measured. Latencies holds
+    the latency of each of its commands in nanoseconds.
+*/
+typedef struct {
+    pthread_t thread;
+    int connects;
+    int commands;
+    int depth;
+    long long *latencies;
+    int count;
+    bool failed;
+
+} Worker;
+
+/** This function gives the current time.
+    @return the time in nanoseconds from some fixed point.
+*/
+static long long now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * NANOS + ts.tv_nsec;
+}
+
+/** This function connects a new client to the server.
+    @return the client's socket, or -1 if it couldn't connect.
+*/
+static int connectClient()
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/** This function writes all of the given bytes to a socket.
+    @param fd the socket.
+    @param *bytes the bytes to write.
+    @param n the number of bytes.
+    @return false if the socket couldn't be written to.
+*/
+static bool sendAll(int fd, char const *bytes, size_t n)
+{
+    while (n > 0) {
+        ssize_t written = write(fd, bytes, n);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        n -= written;
+    }
+    return true;
+}
+
+/** This function reads responses until the server has printed the given number of
+    prompts. A response only ends with a prompt when it is the last thing read, so
+    prompts are counted at the ends of reads, and a read that stops in the middle of a
+    prompt is finished by the next one.
+    @param fd the socket.
+    @param prompts number of prompts to wait for.
+    @return false if the server hung up first.
+*/
+static bool awaitPrompts(int fd, int prompts)
+{
+    char buffer[RESPONSE_BLOCK];
+    // How much of a prompt the last read ended with.
+    int partial = 0;
+    while (prompts > 0) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        // Count every prompt in what was read, including one split across reads.
+        for (ssize_t i = 0; i < n; i++) {
+            partial = buffer[i] == PROMPT[partial] ? partial + 1 : (buffer[i] == PROMPT[0] ? 1 : 0);
+            if (partial == PROMPT_LEN) {
+                prompts--;
+                partial = 0;
+            }
+        }
+    }
+    return true;
+}
+
+/** This function is the start routine for the worker threads. First each worker
+    connects clients one after another, each running one command and quitting. Then it
+    connects one busy client and sends it commands, depth at a time, timing how long
+    each group takes to come back.
+    @param *arg pointer to the worker.
+    @return NULL always.
+*/
+static void *workerThread(void *arg)
+{
+    Worker *worker = (Worker *)arg;
+
+    // Clients that come and go.
+    for (int i = 0; i < worker->connects; i++) {
+        int fd = connectClient();
+        if (fd < 0 || !awaitPrompts(fd, 1) || !sendAll(fd, "list schedule\nquit\n", strlen("list schedule\nquit\n")) ||
+            !awaitPrompts(fd, 1)) {
+            worker->failed = true;
+            if (fd >= 0) {
+                close(fd);
+            }
+            return NULL;
+        }
+        close(fd);
+    }
+
+    // One busy client.
+    int fd = connectClient();
+    if (fd < 0 || !awaitPrompts(fd, 1)) {
+        worker->failed = true;
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+    int sent = 0;
+    while (sent < worker->commands) {
+        // Send a group of commands at once, the server answers them in order.
+        int group = worker->commands - sent < worker->depth ? worker->commands - sent : worker->depth;
+        long long start = now();
+        for (int i = 0; i < group; i++) {
+            char const *command = commands[(sent + i) % COMMAND_COUNT];
+            if (!sendAll(fd, command, strlen(command))) {
+                worker->failed = true;
+                close(fd);
+                return NULL;
+            }
+        }
+        if (!awaitPrompts(fd, group)) {
+            worker->failed = true;
+            close(fd);
+            return NULL;
+        }
+        worker->latencies[worker->count++] = now() - start;
+        sent += group;
+    }
+    close(fd);
+    return NULL;
+}
+
+/** This function compares two latencies for qsort.
+    @param *a pointer to the first latency.
+    @param *b pointer to the second latency.
+    @return negative, zero or positive as the first is less, equal or greater.
+*/
+static int compareLatency(void const *a, void const *b)
+{
+    long long x = *(long long const *)a;
+    long long y = *(long long const *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/** This function replays a script of commands over one connection and prints everything
+    the server sends back. The script is sent while the responses are read, so a long
+    script can't fill up both directions of the socket.
+    @param *script the file of commands.
+    @return the exit status.
+*/
+static int replay(char const *script)
+{
+    int in = open(script, O_RDONLY);
+    if (in < 0) {
+        fprintf(stderr, "Can't open file: %s\n", script);
+        return EXIT_FAILURE;
+    }
+    int fd = connectClient();
+    if (fd < 0) {
+        fprintf(stderr, "Can't connect to server\n");
+        close(in);
+        return EXIT_FAILURE;
+    }
+
+    // Bytes of the script read but not sent yet.
+    char pending[RESPONSE_BLOCK];
+    size_t start = 0;
+    size_t end = 0;
+    bool sending = true;
+    char buffer[RESPONSE_BLOCK];
+    while (1) {
+        // Refill from the script once everything read from it is sent.
+        if (sending && start == end) {
+            ssize_t n = read(in, pending, sizeof(pending));
+            if (n <= 0) {
+                // Tell the server there are no more commands.
+                shutdown(fd, SHUT_WR);
+                sending = false;
+            }
+            else {
+                start = 0;
+                end = n;
+            }
+        }
+
+        struct pollfd poller = { fd, POLLIN | (sending ? POLLOUT : 0), 0 };
+        if (poll(&poller, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (poller.revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n <= 0) {
+                break;
+            }
+            fwrite(buffer, 1, n, stdout);
+        }
+        else if (poller.revents & POLLOUT) {
+            ssize_t n = write(fd, pending + start, end - start);
+            if (n < 0) {
+                // The server hung up, maybe on a quit command. Read what's left.
+                sending = false;
+            }
+            else {
+                start += n;
+            }
+        }
+    }
+
+    close(fd);
+    close(in);
+    return EXIT_SUCCESS;
+}
+
+/** This function prints the usage message and exits.
+*/
+static void usage()
+{
+    fprintf(stderr, "usage: loadgen <socket> [-r script] [-t threads] [-c connects] [-n commands] [-p depth] [-i idle]\n");
+    exit(1);
+}
+
+/** Parses the options and runs the test or the replay.
+    @param argc the number of command-line argument.
+    @param *argv the pointer to each command line argument.
+    @return program exit status.
+*/
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        usage();
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(argv[1]) >= sizeof(addr.sun_path)) {
+        usage();
+    }
+    strcpy(addr.sun_path, argv[1]);
+
+    // Every option has a value after it.
+    char const *script = NULL;
+    int threads = DEFAULT_THREADS;
+    int connects = DEFAULT_CONNECTS;
+    int commandCount = DEFAULT_COMMANDS;
+    int depth = 1;
+    int idle = 0;
+    for (int i = 2; i < argc; i += 2) {
+        if (i + 1 >= argc) {
+            usage();
+        }
+        if (strcmp(argv[i], "-r") == 0) {
+            script = argv[i + 1];
+            continue;
+        }
+        int value = atoi(argv[i + 1]);
+        if (value < 0) {
+            usage();
+        }
+        if (strcmp(argv[i], "-t") == 0 && value > 0) {
+            threads = value;
+        }
+        else if (strcmp(argv[i], "-c") == 0) {
+            connects = value;
+        }
+        else if (strcmp(argv[i], "-n") == 0) {
+            commandCount = value;
+        }
+        else if (strcmp(argv[i], "-p") == 0 && value > 0) {
+            depth = value;
+        }
+        else if (strcmp(argv[i], "-i") == 0) {
+            idle = value;
+        }
+        else {
+            usage();
+        }
+    }
+
+    // A server that hangs up shouldn't kill us in the middle of a write.
+    signal(SIGPIPE, SIG_IGN);
+
+    if (script != NULL) {
+        return replay(script);
+    }
+
+    // Every client needs a descriptor, so allow as many as we are allowed to ask for.
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    // Idle clients stay connected for the whole test, once the server has greeted them.
+    int *idlers = (int *)malloc((idle + 1) * sizeof(int));
+    for (int i = 0; i < idle; i++) {
+        idlers[i] = connectClient();
+        if (idlers[i] < 0 || !awaitPrompts(idlers[i], 1)) {
+            fprintf(stderr, "Can't connect idle client %d\n", i + 1);
+            exit(1);
+        }
+    }
+
+    // Split the clients that come and go and the busy commands over the threads.
+    Worker *workers = (Worker *)calloc(threads, sizeof(Worker));
+    long long start = now();
+    for (int i = 0; i < threads; i++) {
+        workers[i].connects = connects / threads + (i < connects % threads);
+        workers[i].commands = commandCount / threads + (i < commandCount % threads);
+        workers[i].depth = depth;
+        workers[i].latencies = (long long *)malloc((workers[i].commands / depth + 1) * sizeof(long long));
+        pthread_create(&workers[i].thread, NULL, workerThread, &workers[i]);
+    }
+
+    // Put every group's latency together.
+    long long *latencies = (long long *)malloc((commandCount / depth + threads + 1) * sizeof(long long));
+    int count = 0;
+    bool failed = false;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        memcpy(latencies + count, workers[i].latencies, workers[i].count * sizeof(long long));
+        count += workers[i].count;
+        failed = failed || workers[i].failed;
+        free(workers[i].latencies);
+    }
+    long long elapsed = now() - start;
+    if (failed) {
+        fprintf(stderr, "Server hung up or refused a connection\n");
+        exit(1);
+    }
+
+    // The clients that come and go all run before the busy ones on each thread, so time
+    // them apart using the busy clients' latencies.
+    long long busy = 0;
+    for (int i = 0; i < count; i++) {
+        busy += latencies[i];
+    }
+    busy /= threads;
+    long long connecting = elapsed - busy > 0 ? elapsed - busy : 1;
+
+    qsort(latencies, count, sizeof(long long), compareLatency);
+    printf("idle clients: %d\n", idle);
+    printf("connects/sec: %.0f\n", connects * (double) NANOS / connecting);
+    printf("commands/sec: %.0f\n", busy > 0 ? commandCount * (double) NANOS / busy : 0.0);
+    if (count > 0) {
+        printf("latency p50: %.1f us\n", latencies[(count - 1) * P50 / 100] / (double) NANOS_PER_MICRO);
+        printf("latency p99: %.1f us\n", latencies[(count - 1) * P99 / 100] / (double) NANOS_PER_MICRO);
+    }
+
+    // Hang up the idle clients.
+    for (int i = 0; i < idle; i++) {
+        close(idlers[i]);
+    }
+    free(idlers);
+    free(workers);
+    free(latencies);
+    return EXIT_SUCCESS;
+}
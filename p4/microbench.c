@@ -0,0 +1,424 @@
+/** @file microbench.c
+    @author Huy Nguyen (hqnguyen)
+    This program times the main pieces of the schedule program on synthetic catalogs of
+    growing size: reading a course file, sorting the courses, building the views, listing
+    courses, searching names, adding and dropping courses and printing a calendar. It prints one result
+    per line as CSV, or as JSON with -f json, so runs can be saved and compared to catch
+    a change that makes something slower.
+*/
+
+// Needed for mkstemp(), open() and clock_gettime() with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "catalog.h"
+#include "student.h"
+#include "output.h"
+#include "snapshot.h"
+#include "command.h"
+#include "search.h"
+#include "generate.h"
+
+/** Smallest catalog timed */
+#define MIN_COURSES 1000
+
+/** Default largest catalog timed */
+#define DEFAULT_MAX_COURSES 100000
+
+/** Largest catalog that can be timed, which still has unique course ids to spare */
+#define MAX_COURSES 10000000
+
+/** Catalogs grow by this much from one size to the next */
+#define SIZE_STEP 10
+
+/** Whole-catalog benchmarks run until they've handled this many courses in all */
+#define COURSES_PER_BENCHMARK 1000000
+
+/** Most runs of a whole-catalog benchmark */
+#define MAX_RUNS 10
+
+/** Number of times each single-command benchmark is run */
+#define OPERATIONS 100000
+
+/** Nanoseconds in a second */
+#define NANOS 1000000000.0
+
+/** Number of searches timed, each for part of a random course's name */
+#define SEARCHES 10000
+
+/** Length of the text searched for */
+#define SEARCH_LEN 6
+
+/** Longest command line built for the add and drop benchmarks */
+#define COMMAND_LEN 32
+
+/** The result struct holds the timings of one benchmark at one catalog size. Runs is
+    how many times it was timed, and items is how many courses or commands one run
+    handles, so the time per item can be compared between sizes.
+*/
+typedef struct {
+    char const *name;
+    int courses;
+    int runs;
+    long items;
+    double best;
+    double total;
+
+} Result;
+
+/** Whether results are printed as JSON instead of CSV. */
+static bool json = false;
+
+/** Whether a result has been printed yet, so JSON knows when it needs a comma. */
+static bool printedResult = false;
+
+/** This function prints the usage message and exits.
+*/
+static void usage()
+{
+    fprintf(stderr, "usage: microbench [-n courses] [-m max-courses] [-l min-max] [-f csv|json]\n");
+    exit(1);
+}
+
+/** Test function for listing every course, the way list courses does.
+    @param *course pointer to course.
+    @param key not used.
+    @return true always to print all the courses.
+*/
+static bool everyCourse(Course const *course, int key)
+{
+    return true;
+}
+
+/** Helper method to read the clock.
+    @return the time in seconds, from some fixed point in the past.
+*/
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / NANOS;
+}
+
+/** Helper method to start a result.
+    @param *result pointer to the result.
+    @param *name pointer to the name of the benchmark.
+    @param courses the number of courses in the catalog.
+    @param items the number of courses or commands one run handles.
+*/
+static void startResult(Result *result, char const *name, int courses, long items)
+{
+    result->name = name;
+    result->courses = courses;
+    result->runs = 0;
+    result->items = items;
+    result->best = 0;
+    result->total = 0;
+}
+
+/** Helper method to add the time of one run to a result.
+    @param *result pointer to the result.
+    @param seconds how long the run took.
+*/
+static void addRun(Result *result, double seconds)
+{
+    if (result->runs == 0 || seconds < result->best) {
+        result->best = seconds;
+    }
+    result->total += seconds;
+    result->runs++;
+}
+
+/** Helper method to print a result, right away so a long run can be watched.
+    @param *result pointer to the result.
+*/
+static void printResult(Result const *result)
+{
+    double mean = result->runs > 0 ? result->total / result->runs : 0;
+    double perItem = result->items > 0 ? result->best * NANOS / result->items : 0;
+    if (json) {
+        printf("%s  {\"benchmark\": \"%s\", \"courses\": %d, \"runs\": %d, \"items\": %ld, "
+               "\"best_seconds\": %.9f, \"mean_seconds\": %.9f, \"ns_per_item\": %.2f}",
+               printedResult ? ",\n" : "[\n", result->name, result->courses, result->runs,
+               result->items, result->best, mean, perItem);
+    }
+    else {
+        if (!printedResult) {
+            printf("benchmark,courses,runs,items,best_seconds,mean_seconds,ns_per_item\n");
+        }
+        printf("%s,%d,%d,%ld,%.9f,%.9f,%.2f\n", result->name, result->courses, result->runs,
+               result->items, result->best, mean, perItem);
+    }
+    printedResult = true;
+    fflush(stdout);
+}
+
+/** Helper method to decide how many times to run a benchmark over the whole catalog, so
+    small catalogs are run often enough to time well and huge ones only once.
+    @param courses the number of courses in the catalog.
+    @return the number of runs.
+*/
+static int wholeRuns(int courses)
+{
+    int runs = COURSES_PER_BENCHMARK / (courses > 0 ? courses : 1);
+    return runs < 1 ? 1 : runs > MAX_RUNS ? MAX_RUNS : runs;
+}
+
+/** Helper method to time sorting the list of courses, starting from the order they
+    were read in every time.
+    @param *catalog pointer to the catalog.
+    @param *name pointer to the name of the benchmark.
+    @param *compare the compare function to sort with.
+*/
+static void benchSort(Catalog *catalog, char const *name, int (*compare)(void const *va, void const *vb))
+{
+    Course **order = (Course **)malloc((catalog->count + 1) * sizeof(Course *));
+    memcpy(order, catalog->list, catalog->count * sizeof(Course *));
+    Result result;
+    startResult(&result, name, catalog->count, catalog->count);
+    for (int run = wholeRuns(catalog->count); run > 0; run--) {
+        memcpy(catalog->list, order, catalog->count * sizeof(Course *));
+        double start = now();
+        sortCourses(catalog, compare);
+        addRun(&result, now() - start);
+    }
+    memcpy(catalog->list, order, catalog->count * sizeof(Course *));
+    free(order);
+    printResult(&result);
+}
+
+/** Helper method to time searching for courses by part of their name, with text from
+    the middle of random courses' names.
+    @param *catalog pointer to the catalog, with its views built.
+    @param *out pointer to the output the courses found print to.
+*/
+static void benchSearch(Catalog const *catalog, Output *out)
+{
+    // The text is picked ahead of time, so only searching is timed.
+    char (*texts)[NAME_LEN] = malloc(SEARCHES * sizeof(*texts));
+    for (int i = 0; i < SEARCHES; i++) {
+        char const *name = catalog->list[rand() % catalog->count]->name;
+        int len = strlen(name);
+        int at = len > SEARCH_LEN ? rand() % (len - SEARCH_LEN) : 0;
+        snprintf(texts[i], NAME_LEN, "%.*s", SEARCH_LEN, name + at);
+    }
+
+    Result result;
+    startResult(&result, "searchCourses", catalog->count, SEARCHES);
+    double start = now();
+    for (int i = 0; i < SEARCHES; i++) {
+        searchCourses(out, catalog, texts[i]);
+    }
+    flushOutput(out);
+    addRun(&result, now() - start);
+    printResult(&result);
+    free(texts);
+}
+
+/** Helper method to time adding and dropping courses with the add and drop commands. A
+    schedule is filled up with random courses from the catalog and then emptied again,
+    over and over, timing the adds and the drops on their own.
+    @param *state pointer to the command state, with an empty schedule.
+    @param *mix pointer to the mix the catalog was made from.
+    @param *out pointer to the output the commands print to.
+*/
+static void benchAddDrop(CommandState *state, CourseMix const *mix, Output *out)
+{
+    // The commands are made up ahead of time, so only running them is timed.
+    char (*adds)[COMMAND_LEN] = malloc(OPERATIONS * sizeof(*adds));
+    char (*drops)[COMMAND_LEN] = malloc(OPERATIONS * sizeof(*drops));
+    for (int i = 0; i < OPERATIONS; i++) {
+        char dept[DEPARTMENT_LEN];
+        char number[NUMBER_LEN];
+        courseName(mix, rand() % mix->courses, dept, number);
+        snprintf(adds[i], COMMAND_LEN, "add %s %s", dept, number);
+        snprintf(drops[i], COMMAND_LEN, "drop %s %s", dept, number);
+    }
+
+    Result added;
+    Result dropped;
+    startResult(&added, "addCourse", mix->courses, OPERATIONS);
+    startResult(&dropped, "dropCourse", mix->courses, OPERATIONS);
+    double addTime = 0;
+    double dropTime = 0;
+    for (int i = 0; i < OPERATIONS; i += SCHEDULE_MAX_LEN) {
+        int n = OPERATIONS - i < SCHEDULE_MAX_LEN ? OPERATIONS - i : SCHEDULE_MAX_LEN;
+        double start = now();
+        for (int j = 0; j < n; j++) {
+            runCommand(state, adds[i + j], out);
+        }
+        double middle = now();
+        for (int j = 0; j < n; j++) {
+            runCommand(state, drops[i + j], out);
+        }
+        addTime += middle - start;
+        dropTime += now() - middle;
+    }
+    addRun(&added, addTime);
+    addRun(&dropped, dropTime);
+    printResult(&added);
+    printResult(&dropped);
+    free(adds);
+    free(drops);
+}
+
+/** Helper method to time printing the calendar of a full schedule.
+    @param *state pointer to the command state, with an empty schedule.
+    @param *mix pointer to the mix the catalog was made from.
+    @param *out pointer to the output the calendar prints to.
+*/
+static void benchCalendar(CommandState *state, CourseMix const *mix, Output *out)
+{
+    // Fill up the schedule, with whichever courses don't overlap.
+    for (int i = 0; i < SCHEDULE_MAX_LEN * SCHEDULE_MAX_LEN; i++) {
+        char dept[DEPARTMENT_LEN];
+        char number[NUMBER_LEN];
+        char command[COMMAND_LEN];
+        courseName(mix, rand() % mix->courses, dept, number);
+        snprintf(command, COMMAND_LEN, "add %s %s", dept, number);
+        runCommand(state, command, out);
+    }
+
+    Schedule *schedule = sessionSchedule(state->sessions, state->current);
+    Result result;
+    startResult(&result, "printCalendar", mix->courses, OPERATIONS);
+    double start = now();
+    for (int i = 0; i < OPERATIONS; i++) {
+        printCalendar(out, schedule);
+    }
+    addRun(&result, now() - start);
+    printResult(&result);
+}
+
+/** Helper method to run every benchmark on a catalog of the given size.
+    @param *mix pointer to the mix to make the catalog from.
+    @param *out pointer to the output lists and commands print to.
+*/
+static void benchSize(CourseMix const *mix, Output *out)
+{
+    // The catalog is read from a real course file, made up for this size.
+    char filename[] = "/tmp/microbench-XXXXXX";
+    int fd = mkstemp(filename);
+    FILE *fp = fd < 0 ? NULL : fdopen(fd, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Can't make a course file\n");
+        exit(1);
+    }
+    writeCourses(fp, mix);
+    fclose(fp);
+
+    Result result;
+    startResult(&result, "readCourses", mix->courses, mix->courses);
+    for (int run = wholeRuns(mix->courses); run > 0; run--) {
+        Catalog *catalog = makeCatalog();
+        double start = now();
+        readCourses(filename, catalog);
+        addRun(&result, now() - start);
+        freeCatalog(catalog);
+    }
+    printResult(&result);
+
+    // The rest all work on one catalog.
+    Catalog *catalog = makeCatalog();
+    readCourses(filename, catalog);
+    benchSort(catalog, "sortCourses/id", compareId);
+    benchSort(catalog, "sortCourses/name", compareName);
+
+    startResult(&result, "buildViews", mix->courses, mix->courses);
+    for (int run = wholeRuns(mix->courses); run > 0; run--) {
+        double start = now();
+        buildViews(catalog);
+        addRun(&result, now() - start);
+    }
+    printResult(&result);
+
+    startResult(&result, "listCourses", mix->courses, mix->courses);
+    for (int run = wholeRuns(mix->courses); run > 0; run--) {
+        double start = now();
+        listCourses(out, catalog->byId, catalog->count, everyCourse, 0);
+        flushOutput(out);
+        addRun(&result, now() - start);
+    }
+    printResult(&result);
+    benchSearch(catalog, out);
+
+    // Commands run the way the program runs them, on a live catalog.
+    char const *filenames[] = { filename };
+    LiveCatalog *live = makeLiveCatalog(catalog, filenames, 1, 1);
+    CommandState *state = makeCommandState(live);
+    benchAddDrop(state, mix, out);
+    benchCalendar(state, mix, out);
+    flushOutput(out);
+    freeCommandState(state);
+    freeLiveCatalog(live);
+    unlink(filename);
+}
+
+/** Parses the options and runs the benchmarks at each catalog size.
+    @param argc the number of command-line argument.
+    @param *argv the pointer to each command line argument.
+    @return the exit status.
+*/
+int main(int argc, char *argv[])
+{
+    // Every option has a value after it.
+    int minCourses = MIN_COURSES;
+    int maxCourses = DEFAULT_MAX_COURSES;
+    int minName = DEFAULT_MIN_NAME;
+    int maxName = DEFAULT_MAX_NAME;
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 >= argc) {
+            usage();
+        }
+        char const *value = argv[i + 1];
+        if (strcmp(argv[i], "-n") == 0) {
+            minCourses = maxCourses = atoi(value);
+        }
+        else if (strcmp(argv[i], "-m") == 0) {
+            maxCourses = atoi(value);
+        }
+        else if (strcmp(argv[i], "-l") == 0) {
+            if (sscanf(value, "%d-%d", &minName, &maxName) != 2) {
+                usage();
+            }
+        }
+        else if (strcmp(argv[i], "-f") == 0 && strcmp(value, "json") == 0) {
+            json = true;
+        }
+        else if (strcmp(argv[i], "-f") != 0 || strcmp(value, "csv") != 0) {
+            usage();
+        }
+    }
+    if (minCourses < 1 || maxCourses > MAX_COURSES || minCourses > maxCourses) {
+        usage();
+    }
+
+    // Lists and commands print to nowhere, but still go through a real descriptor.
+    int fd = open("/dev/null", O_WRONLY);
+    Output *out = makeOutput(fd);
+    srand(1);
+    for (long courses = minCourses; courses <= maxCourses; courses *= SIZE_STEP) {
+        CourseMix mix;
+        defaultMix(&mix, courses);
+        mix.minName = minName;
+        mix.maxName = maxName;
+        if (!isMixValid(&mix)) {
+            usage();
+        }
+        benchSize(&mix, out);
+    }
+    if (json && printedResult) {
+        printf("\n]\n");
+    }
+    freeOutput(out);
+    close(fd);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/** @file output.c
+    @author Huy Nguyen (hqnguyen)
+    This component collects the program's output in a buffer and writes it out in large
+    blocks, so a long run of commands doesn't cost a system call for every line.
+*/
+
+// Needed for write() with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "output.h"
+#include "input.h"
+
+/** Spaces to pad fields with, longer than any field width we use. */
+static char const spaces[] = "                                ";
+
+Output *makeOutput(int fd) 
+{
+    return makeSizedOutput(fd, OUTPUT_BLOCK);
+}
+
+Output *makeSizedOutput(int fd, size_t capacity) 
+{
+    // Allocate memory for the output and its buffer.
+    Output *out = (Output *)malloc(sizeof(Output));
+    out->fd = fd;
+    out->capacity = capacity;
+    out->buffer = (char *)malloc(out->capacity);
+    out->len = 0;
+    
+    return out;
+}
+
+void freeOutput(Output *out) 
+{
+    // Anything still waiting gets written before the buffer goes away.
+    flushOutput(out);
+    free(out->buffer);
+    free(out);
+}
+
+bool flushOutput(Output *out) 
+{
+    // An output that only collects keeps its bytes for the caller.
+    if (out->fd < 0) {
+        return true;
+    }
+    
+    // Keep writing until the whole buffer is out, retrying if a signal interrupts.
+    size_t written = 0;
+    while (written < out->len) {
+        ssize_t n = write(out->fd, out->buffer + written, out->len - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        // Drop what can't be written, there's no one to report it to.
+        if (n <= 0) {
+            out->len = 0;
+            return false;
+        }
+        written += n;
+    }
+    out->len = 0;
+    
+    return true;
+}
+
+void putBytes(Output *out, char const *bytes, size_t n) 
+{
+    // If it doesn't fit, make room by writing out the buffer, or by growing it if the
+    // output only collects or the bytes are bigger than the whole buffer.
+    if (out->len + n > out->capacity) {
+        if (out->fd >= 0) {
+            flushOutput(out);
+        }
+        while (out->len + n > out->capacity) {
+            out->capacity *= DOUBLE_ARRAY;
+            out->buffer = (char *)realloc(out->buffer, out->capacity);
+        }
+    }
+    
+    memcpy(out->buffer + out->len, bytes, n);
+    out->len += n;
+}
+
+/** This function adds the given number of spaces to the output.
+    @param *out pointer to the output.
+    @param n number of spaces to add.
+*/
+static void putSpaces(Output *out, int n) 
+{
+    // Add the spaces a piece of the spaces string at a time.
+    while (n > 0) {
+        int piece = n < (int)sizeof(spaces) - 1 ? n : (int)sizeof(spaces) - 1;
+        putBytes(out, spaces, piece);
+        n -= piece;
+    }
+}
+
+void putText(Output *out, char const *text) 
+{
+    putBytes(out, text, strlen(text));
+}
+
+void putLine(Output *out, char const *text) 
+{
+    putBytes(out, text, strlen(text));
+    putBytes(out, "\n", 1);
+}
+
+void putLeft(Output *out, char const *text, int width) 
+{
+    // Text first, then the padding after it.
+    int len = strlen(text);
+    putBytes(out, text, len);
+    putSpaces(out, width - len);
+}
+
+void putRight(Output *out, char const *text, int width) 
+{
+    // Padding first, then the text after it.
+    int len = strlen(text);
+    putSpaces(out, width - len);
+    putBytes(out, text, len);
+}
@@ -0,0 +1,91 @@
+/** @file output.h
+    @author Huy Nguyen (hqnguyen)
+    This is the header file for the component that collects the program's output in a
+    buffer and writes it out in large blocks.
+*/
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Number of bytes an Output collects before writing them to its file */
+#define OUTPUT_BLOCK 65536
+
+/** The output struct collects text in buffer so it can be written with a few large
+    writes instead of one for every line. Len is the number of bytes waiting in the
+    buffer and capacity is its size. If fd is negative, nothing is ever written and the
+    buffer grows instead, so the caller can take the bytes out itself.
+*/
+typedef struct {
+    int fd;
+    char *buffer;
+    size_t len;
+    size_t capacity;
+    
+} Output;
+
+/** This function dynamically allocate memory for an Output and its buffer.
+    @param fd the file descriptor to write to, or -1 to only collect the output. It is
+              not closed by the output.
+    @return a pointer to the new output.
+*/
+Output *makeOutput(int fd);
+
+/** This function dynamically allocate memory for an Output with a buffer of the given
+    size, for outputs that are mostly idle.
+    @param fd the file descriptor to write to, or -1 to only collect the output.
+    @param capacity the starting size of the buffer.
+    @return a pointer to the new output.
+*/
+Output *makeSizedOutput(int fd, size_t capacity);
+
+/** This function writes anything left in the buffer, then free all the memory for the
+    given Output.
+    @param *out pointer to the output.
+*/
+void freeOutput(Output *out);
+
+/** This function adds the given bytes to the output.
+    @param *out pointer to the output.
+    @param *bytes pointer to the bytes to add.
+    @param n number of bytes to add.
+*/
+void putBytes(Output *out, char const *bytes, size_t n);
+
+/** This function adds a string to the output.
+    @param *out pointer to the output.
+    @param *text the string to add.
+*/
+void putText(Output *out, char const *text);
+
+/** This function adds a string to the output followed by a newline.
+    @param *out pointer to the output.
+    @param *text the string to add.
+*/
+void putLine(Output *out, char const *text);
+
+/** This function adds a string to the output, padded with spaces on the right to be at
+    least width characters, like the %-Ns conversion in printf.
+    @param *out pointer to the output.
+    @param *text the string to add.
+    @param width the smallest number of characters to add.
+*/
+void putLeft(Output *out, char const *text, int width);
+
+/** This function adds a string to the output, padded with spaces on the left to be at
+    least width characters, like the %Ns conversion in printf.
+    @param *out pointer to the output.
+    @param *text the string to add.
+    @param width the smallest number of characters to add.
+*/
+void putRight(Output *out, char const *text, int width);
+
+/** This function writes everything in the buffer to the output's file. It does nothing
+    for an output that only collects.
+    @param *out pointer to the output.
+    @return false if the file couldn't be written.
+*/
+bool flushOutput(Output *out);
+
+#endif
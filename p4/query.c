@@ -0,0 +1,317 @@
+/** @file query.c
+    @author Huy Nguyen (hqnguyen)
+    This component parses list queries and runs them against the catalog. A query is
+    planned on whichever index narrows it down the most, the department buckets, the
+    timeslot buckets or a single course id lookup, and the conditions that index
+    doesn't cover are checked on each course it gives back.
+*/
+
+// Needed for strtok_r() with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "query.h"
+
+/** The most bucket ranges a plan reads from, one for each time on the given days */
+#define MAX_RANGES NUMBER_OF_VALID_TIME
+
+/** The plan struct holds the sorted runs of courses a query reads its candidates from.
+    Every run is sorted by the same order, by course id unless the plan reads byName,
+    and between them they hold every course that can match. Total is how many courses
+    the runs hold.
+*/
+typedef struct {
+    Course * const *view[MAX_RANGES];
+    int count[MAX_RANGES];
+    int ranges;
+    int total;
+
+} Plan;
+
+bool isQueryWord( char const *word )
+{
+    return strcmp(word, "where") == 0 || strcmp(word, "sort") == 0 ||
+           strcmp(word, "limit") == 0 || strcmp(word, "offset") == 0;
+}
+
+/** Helper method to read the number after limit or offset.
+    @param *word pointer to the word, or NULL if the line ended.
+    @param *value pointer to where the number is stored.
+    @return true if the word is a number with no more than QUERY_NUMBER_DIGITS digits.
+*/
+static bool parseCount( char const *word, int *value )
+{
+    if (word == NULL || strlen(word) == 0 || strlen(word) > QUERY_NUMBER_DIGITS) {
+        return false;
+    }
+    *value = 0;
+    for (int i = 0; word[i]; i++) {
+        if (!isdigit(word[i])) {
+            return false;
+        }
+        *value = *value * 10 + (word[i] - '0');
+    }
+    return true;
+}
+
+/** Helper method to read one condition of a where clause into the query.
+    @param *word pointer to the condition, a key, an equal sign and a value.
+    @param *query pointer to the query.
+    @return true if the key is known, hasn't been given before and the value is valid.
+*/
+static bool parseCondition( char *word, Query *query )
+{
+    char *value = strchr(word, '=');
+    *value++ = '\0';
+    if (strcmp(word, "dept") == 0 && query->dept < 0) {
+        query->dept = packDepartment(value);
+        return query->dept >= 0;
+    }
+    if (strcmp(word, "number") == 0 && query->number < 0) {
+        if (strlen(value) != NUMBER_LETTERS) {
+            return false;
+        }
+        query->number = 0;
+        for (int i = 0; i < NUMBER_LETTERS; i++) {
+            if (!isdigit(value[i])) {
+                return false;
+            }
+            query->number = query->number * 10 + (value[i] - '0');
+        }
+        return true;
+    }
+    // The days and the time are checked by packing them with a valid time or days.
+    if (strcmp(word, "days") == 0 && query->day < 0) {
+        int slot = packTimeslot(value, "8:30");
+        query->day = slot / NUMBER_OF_VALID_TIME;
+        return slot >= 0;
+    }
+    if (strcmp(word, "time") == 0 && query->time < 0) {
+        int slot = packTimeslot("MW", value);
+        query->time = slot % NUMBER_OF_VALID_TIME;
+        return slot >= 0;
+    }
+    return false;
+}
+
+bool parseQuery( char const *input, Query *query )
+{
+    // Nothing is filtered, sorted by name or limited until the query says so.
+    *query = (Query) { -1, -1, -1, -1, false, -1, 0 };
+    bool hasWhere = false, hasSort = false, hasLimit = false, hasOffset = false;
+
+    // Split a copy of the line into words, skipping list. Commands run on several
+    // threads at once, so the position in the line is kept here.
+    char *line = (char *) malloc(strlen(input) + 1);
+    strcpy(line, input);
+    char *rest;
+    strtok_r(line, " \t", &rest);
+    char *word = strtok_r(NULL, " \t", &rest);
+
+    bool valid = true;
+    while (word && valid) {
+        // A where clause needs at least one condition, and takes every word after it
+        // that has an equal sign in it.
+        if (strcmp(word, "where") == 0 && !hasWhere) {
+            hasWhere = true;
+            word = strtok_r(NULL, " \t", &rest);
+            valid = word && strchr(word, '=');
+            while (valid && word && strchr(word, '=')) {
+                valid = parseCondition(word, query);
+                word = strtok_r(NULL, " \t", &rest);
+            }
+            continue;
+        }
+        else if (strcmp(word, "sort") == 0 && !hasSort) {
+            hasSort = true;
+            word = strtok_r(NULL, " \t", &rest);
+            valid = word && (strcmp(word, "id") == 0 || strcmp(word, "name") == 0);
+            query->byName = valid && strcmp(word, "name") == 0;
+        }
+        else if (strcmp(word, "limit") == 0 && !hasLimit) {
+            hasLimit = true;
+            valid = parseCount(strtok_r(NULL, " \t", &rest), &query->limit);
+        }
+        else if (strcmp(word, "offset") == 0 && !hasOffset) {
+            hasOffset = true;
+            valid = parseCount(strtok_r(NULL, " \t", &rest), &query->offset);
+        }
+        else {
+            valid = false;
+        }
+        word = strtok_r(NULL, " \t", &rest);
+    }
+    free(line);
+    return valid;
+}
+
+/** Helper method to check a course against every condition of a query.
+    @param *course pointer to the course.
+    @param *query pointer to the query.
+    @return true if the course matches.
+*/
+static bool matchQuery( Course const *course, Query const *query )
+{
+    return (query->dept < 0 || course->id / NUMBERS_PER_DEPARTMENT == query->dept) &&
+           (query->number < 0 || course->id % NUMBERS_PER_DEPARTMENT == query->number) &&
+           (query->day < 0 || course->slot / NUMBER_OF_VALID_TIME == query->day) &&
+           (query->time < 0 || course->slot % NUMBER_OF_VALID_TIME == query->time);
+}
+
+/** Helper method to add a run of courses to a plan.
+    @param *plan pointer to the plan.
+    @param *view the courses in the run.
+    @param count the number of courses in the run.
+*/
+static void addRange( Plan *plan, Course * const *view, int count )
+{
+    plan->view[plan->ranges] = view;
+    plan->count[plan->ranges++] = count;
+    plan->total += count;
+}
+
+/** This function picks the index with the fewest candidates for a query. A course id
+    is a single lookup, and otherwise the department's bucket is compared with the
+    buckets of the timeslots the query allows, falling back to the whole catalog.
+    @param *catalog pointer to the catalog.
+    @param *query pointer to the query.
+    @param *plan pointer to where the plan is stored.
+    @param *single pointer to where the course is stored for a course id lookup.
+*/
+static void planQuery( Catalog const *catalog, Query const *query, Plan *plan, Course **single )
+{
+    plan->ranges = plan->total = 0;
+    if (query->dept >= 0 && query->number >= 0) {
+        *single = findCourseById(catalog, query->dept * NUMBERS_PER_DEPARTMENT + query->number);
+        addRange(plan, single, *single ? 1 : 0);
+        return;
+    }
+
+    // Every course to start with, then anything smaller.
+    addRange(plan, catalog->byId, catalog->count);
+    if (query->dept >= 0) {
+        int count;
+        Course **view = departmentView(catalog, query->dept, &count);
+        if (count < plan->total) {
+            plan->ranges = plan->total = 0;
+            addRange(plan, view, count);
+        }
+    }
+    if (query->day >= 0 || query->time >= 0) {
+        Plan slots = { .ranges = 0, .total = 0 };
+        for (int s = 0; s < TIMESLOT_COUNT; s++) {
+            if ((query->day < 0 || s / NUMBER_OF_VALID_TIME == query->day) &&
+                (query->time < 0 || s % NUMBER_OF_VALID_TIME == query->time)) {
+                int count;
+                Course **view = timeslotView(catalog, s, &count);
+                addRange(&slots, view, count);
+            }
+        }
+        if (slots.total < plan->total) {
+            *plan = slots;
+        }
+    }
+}
+
+/** This function lists the matches of a plan in the order of its runs, merging them by
+    course id when there is more than one, and stops once the limit is printed.
+    @param *out where to print the courses.
+    @param *plan pointer to the plan.
+    @param *query pointer to the query.
+*/
+static void listPlan( Output *out, Plan const *plan, Query const *query )
+{
+    int next[MAX_RANGES] = { 0 };
+    int skip = query->offset;
+    int left = query->limit;
+    while (left != 0) {
+        // Take the run whose next course has the smallest id.
+        int best = -1;
+        for (int r = 0; r < plan->ranges; r++) {
+            if (next[r] < plan->count[r] &&
+                (best < 0 || plan->view[r][next[r]]->id < plan->view[best][next[best]]->id)) {
+                best = r;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        Course const *course = plan->view[best][next[best]++];
+        if (matchQuery(course, query)) {
+            if (skip > 0) {
+                skip--;
+            }
+            else {
+                printCourse(out, course);
+                left--;
+            }
+        }
+    }
+}
+
+/** This function lists the matches of a plan sorted by name. When only a few courses are
+    needed, or the plan holds most of the catalog, it's cheaper to read byName in order
+    and stop at the limit, and otherwise the plan's courses are sorted by name.
+    @param *out where to print the courses.
+    @param *catalog pointer to the catalog.
+    @param *plan pointer to the plan.
+    @param *query pointer to the query.
+*/
+static void listByName( Output *out, Catalog const *catalog, Plan const *plan, Query const *query )
+{
+    // Matches are spread out through byName, so reading it until the ones needed are
+    // found takes about as many courses as the catalog has for each course in the plan.
+    // Sorting the plan takes about n log n.
+    double wanted = query->limit < 0 ? plan->total : (double) query->offset + query->limit;
+    if (wanted > plan->total) {
+        wanted = plan->total;
+    }
+    double scan = plan->total == 0 ? 0 : wanted * catalog->count / plan->total;
+    double sort = plan->total;
+    for (int n = plan->total; n > 1; n /= 2) {
+        sort += plan->total;
+    }
+
+    Plan byName = { .ranges = 0, .total = 0 };
+    Course **sorted = NULL;
+    if (scan <= sort) {
+        addRange(&byName, catalog->byName, catalog->count);
+    }
+    else {
+        sorted = (Course **) malloc((plan->total + 1) * sizeof(Course*));
+        int n = 0;
+        for (int r = 0; r < plan->ranges; r++) {
+            for (int i = 0; i < plan->count[r]; i++) {
+                if (matchQuery(plan->view[r][i], query)) {
+                    sorted[n++] = plan->view[r][i];
+                }
+            }
+        }
+        qsort(sorted, n, sizeof(Course*), compareName);
+        addRange(&byName, sorted, n);
+    }
+
+    listPlan(out, &byName, query);
+    free(sorted);
+}
+
+void runQuery( Output *out, Catalog const *catalog, Query const *query )
+{
+    putText(out, LIST_HEADER);
+    Plan plan;
+    Course *single = NULL;
+    planQuery(catalog, query, &plan, &single);
+    if (plan.total == 0) {
+        return;
+    }
+    if (query->byName) {
+        listByName(out, catalog, &plan, query);
+    }
+    else {
+        listPlan(out, &plan, query);
+    }
+}
@@ -0,0 +1,60 @@
+/** @file query.h
+    @author Huy Nguyen (hqnguyen)
+    This is the header file for the component that runs list queries, like
+    list where dept=CSC days=MW sort name limit 20 offset 40, against the catalog's
+    indexes.
+*/
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <stdbool.h>
+
+#include "catalog.h"
+#include "output.h"
+
+/** Longest number that can be given to limit or offset, in digits */
+#define QUERY_NUMBER_DIGITS 9
+
+/** The query struct holds a parsed list query. Each condition is -1 if the query
+    doesn't have it: dept is a department packed with packDepartment(), number is the
+    course number, day is which days the course meets, as in the first half of a packed
+    timeslot, and time which time it starts, as in the second half. Courses are listed
+    by name if byName is true and by course id otherwise, skipping the first offset of
+    them and then listing at most limit, or all of them if limit is -1.
+*/
+typedef struct {
+    int dept;
+    int number;
+    int day;
+    int time;
+    bool byName;
+    int limit;
+    int offset;
+
+} Query;
+
+/** This function checks whether the word after list starts a query.
+    @param *word pointer to the word.
+    @return true if it is where, sort, limit or offset.
+*/
+bool isQueryWord( char const *word );
+
+/** This function parses a list query. After list come any of where and its conditions,
+    sort id or sort name, limit and offset, in any order but each only once. The
+    conditions are dept=, number=, days= and time=, each only once.
+    @param *input pointer to the whole command line.
+    @param *query pointer to where the parsed query is stored.
+    @return true if the query is valid and false otherwise.
+*/
+bool parseQuery( char const *input, Query *query );
+
+/** This function lists the courses that match a query. The smallest index that holds
+    every match is picked to read them from, the rest of the conditions are checked on
+    each course it has, and reading stops as soon as the limit is reached.
+    @param *out where to print the courses.
+    @param *catalog pointer to the catalog, with its views built.
+    @param *query pointer to the query.
+*/
+void runQuery( Output *out, Catalog const *catalog, Query const *query );
+
+#endif
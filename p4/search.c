@@ -0,0 +1,184 @@
+/** @file search.c
+    @author Huy Nguyen (hqnguyen)
+    This component finds courses by part of their name. Text of at least three characters
+    is looked up in the catalog's name trigram index, and only the courses in every
+    bucket the text's trigrams hash to are checked for it.
+*/
+
+// Needed for memmem() with -std=c99.
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "search.h"
+
+/** Helper method to put text in the form names are matched in: lower case, with each run
+    of whitespace a single space and none at the start or end.
+    @param *text pointer to the text.
+    @param *folded where to store the folded text, with room for all of text.
+    @return the length of the folded text.
+*/
+static int foldText( char const *text, char *folded )
+{
+    int len = 0;
+    for (int i = 0; text[i]; i++) {
+        if (!isspace((unsigned char) text[i])) {
+            if (len > 0 && isspace((unsigned char) text[i - 1])) {
+                folded[len++] = ' ';
+            }
+            folded[len++] = tolower((unsigned char) text[i]);
+        }
+    }
+    folded[len] = '\0';
+    return len;
+}
+
+/** Helper method to check whether a course's name has the text in it.
+    @param *course pointer to the course.
+    @param *text pointer to the folded text.
+    @param len the length of the text.
+    @param prefix true if the name has to start with the text.
+    @return true if the course matches.
+*/
+static bool matchName( Course const *course, char const *text, int len, bool prefix )
+{
+    char name[NAME_LEN];
+    int n = 0;
+    for (; course->name[n]; n++) {
+        name[n] = tolower((unsigned char) course->name[n]);
+    }
+    if (prefix) {
+        return n >= len && memcmp(name, text, len) == 0;
+    }
+    return memmem(name, n, text, len) != NULL;
+}
+
+/** Helper method to keep only the candidates that are also in a bucket. Both are sorted,
+    so each candidate is binary searched for after where the one before it was.
+    @param *candidates array of candidate positions, sorted.
+    @param count the number of candidates.
+    @param *view the positions in the bucket, sorted.
+    @param n the number of positions in the bucket.
+    @return the number of candidates kept, at the start of the array.
+*/
+static int intersect( int *candidates, int count, int const *view, int n )
+{
+    int kept = 0;
+    int low = 0;
+    for (int i = 0; i < count && low < n; i++) {
+        int high = n;
+        while (low < high) {
+            int mid = low + (high - low) / 2;
+            if (view[mid] < candidates[i]) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        if (low < n && view[low] == candidates[i]) {
+            candidates[kept++] = candidates[i];
+        }
+    }
+    return kept;
+}
+
+/** This function lists the courses that match text of at least a trigram, using the
+    name trigram index.
+    @param *out where to print the courses.
+    @param *catalog pointer to the catalog.
+    @param *text pointer to the folded text.
+    @param len the length of the text.
+    @param prefix true if the name has to start with the text.
+*/
+static void searchTrigrams( Output *out, Catalog const *catalog, char const *text, int len, bool prefix )
+{
+    // Find the bucket of each trigram in the text, smallest bucket first.
+    int buckets[NAME_LETTERS];
+    int sizes[NAME_LETTERS];
+    int grams = 0;
+    for (int i = 0; i + TRIGRAM_LEN <= len; i++) {
+        int bucket = trigramBucket(text + i);
+        int at = 0;
+        while (at < grams && buckets[at] != bucket) {
+            at++;
+        }
+        if (at < grams) {
+            continue;
+        }
+        int size;
+        trigramView(catalog, bucket, &size);
+        while (at > 0 && sizes[at - 1] > size) {
+            at--;
+        }
+        memmove(buckets + at + 1, buckets + at, (grams - at) * sizeof(int));
+        memmove(sizes + at + 1, sizes + at, (grams - at) * sizeof(int));
+        buckets[at] = bucket;
+        sizes[at] = size;
+        grams++;
+    }
+
+    // Start with the smallest bucket and keep the courses that are in the rest too.
+    int count;
+    int const *view = trigramView(catalog, buckets[0], &count);
+    int *candidates = (int *) malloc((count + 1) * sizeof(int));
+    memcpy(candidates, view, count * sizeof(int));
+    for (int g = 1; g < grams && count > 0; g++) {
+        int n;
+        view = trigramView(catalog, buckets[g], &n);
+        count = intersect(candidates, count, view, n);
+    }
+
+    // Buckets are shared by other trigrams, and the trigrams don't have to be next to
+    // each other, so check the names of the courses left and sort the matches by id.
+    Course **matches = (Course **) malloc((count + 1) * sizeof(Course*));
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        Course *course = catalog->list[candidates[i]];
+        if (matchName(course, text, len, prefix)) {
+            matches[found++] = course;
+        }
+    }
+    qsort(matches, found, sizeof(Course*), compareId);
+    for (int i = 0; i < found; i++) {
+        printCourse(out, matches[i]);
+    }
+    free(matches);
+    free(candidates);
+}
+
+bool searchCourses( Output *out, Catalog const *catalog, char const *text )
+{
+    while (isspace((unsigned char) *text)) {
+        text++;
+    }
+    bool prefix = *text == SEARCH_PREFIX;
+    if (prefix) {
+        text++;
+    }
+    char *folded = (char *) malloc(strlen(text) + 1);
+    int len = foldText(text, folded);
+    if (len == 0) {
+        free(folded);
+        return false;
+    }
+
+    putText(out, LIST_HEADER);
+    // Text that's too short to have a trigram is checked against every course, and
+    // text that's longer than a name can't match anything.
+    if (len < TRIGRAM_LEN) {
+        for (int i = 0; i < catalog->count; i++) {
+            if (matchName(catalog->byId[i], folded, len, prefix)) {
+                printCourse(out, catalog->byId[i]);
+            }
+        }
+    }
+    else if (len <= NAME_LETTERS) {
+        searchTrigrams(out, catalog, folded, len, prefix);
+    }
+    free(folded);
+    return true;
+}
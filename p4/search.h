@@ -0,0 +1,29 @@
+/** @file search.h
+    @author Huy Nguyen (hqnguyen)
+    This is the header file for the component that finds courses by part of their name,
+    for the search command.
+*/
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdbool.h>
+
+#include "catalog.h"
+#include "output.h"
+
+/** Put at the start of the text to search for, it only matches the start of a name */
+#define SEARCH_PREFIX '^'
+
+/** This function lists the courses whose name has some text in it, ignoring case, sorted
+    by course id. Runs of whitespace in the text match a single space, like they do in
+    course names. The courses that have every trigram of the text in their name are
+    found with the name trigram index, then the ones that really have the text are kept.
+    @param *out where to print the courses.
+    @param *catalog pointer to the catalog, with its views built.
+    @param *text pointer to the text, which starts with SEARCH_PREFIX to only match
+    names that start with the rest of it.
+    @return false if there is no text to search for and true otherwise.
+*/
+bool searchCourses( Output *out, Catalog const *catalog, char const *text );
+
+#endif
@@ -0,0 +1,666 @@
+/** @file server.c
+    @author Huy Nguyen (hqnguyen)
+    This component serves the catalog to clients over a Unix domain socket. Clients are
+    spread over a few shards, each an epoll event loop on its own thread, so a large
+    number of mostly idle clients costs a little memory each instead of a thread each.
+    Another thread watches the course files and reloads the catalog when they change.
+*/
+
+// Needed for accept4(), epoll and EPOLLEXCLUSIVE.
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <poll.h>
+
+#include "server.h"
+#include "command.h"
+
+// Older headers don't have it, but any kernel with epoll ignores flags it doesn't know.
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1u << 28)
+#endif
+
+/** The client struct is one connection. The reader collects the bytes the client sent
+    until they make up whole commands, and out collects the responses, of which the
+    first sent bytes have been written. Done is set once the client quit or hung up, and
+    events is what the shard's epoll is watching the socket for, or 0 if the socket isn't
+    in it. Each shard keeps its clients in a list linked by prev and next. Busy is set
+    while the client's reload or load job runs on the watcher thread, and the client's
+    commands wait until it's done. The job is in a list linked by nextJob, first the
+    watcher's list of jobs to run and then the shard's list of finished ones, and status
+    and failed are what it came back with.
+*/
+typedef struct ClientStruct {
+    struct ClientStruct *prev;
+    struct ClientStruct *next;
+    struct ShardStruct *shard;
+    int fd;
+    LineReader *reader;
+    Output *out;
+    size_t sent;
+    bool done;
+    uint32_t events;
+    CommandState *state;
+    
+    bool busy;
+    struct ClientStruct *nextJob;
+    LoadStatus status;
+    char const *failed;
+    
+} Client;
+
+/** The shard struct is one event loop. Each shard has its own epoll instance with the
+    listening socket, the shard's own clients and its wakeup eventfd in it, and runs on
+    its own thread. The wakeup eventfd tells the shard a new catalog was published or
+    some of its clients' jobs are finished, which the watcher puts in finished.
+*/
+typedef struct ShardStruct {
+    LiveCatalog *live;
+    struct WatcherStruct *watcher;
+    int listener;
+    int epoll;
+    int wakeup;
+    Client *clients;
+    Client *finished;
+    pthread_t thread;
+    
+} Shard;
+
+/** The watcher struct is what the thread that reloads the catalog works with: the
+    shards to tell about a new catalog, an inotify instance watching the directories of
+    the course files, and the eventfd clients ask for their jobs to be run on. The jobs
+    wait in order from jobs to lastJob, and lock is held to change that list or any
+    shard's finished list. Running is set if the thread started, so clients can hand
+    their jobs to it.
+*/
+typedef struct WatcherStruct {
+    LiveCatalog *live;
+    Shard *shards;
+    int count;
+    int inotify;
+    int requests;
+    
+    pthread_mutex_t lock;
+    Client *jobs;
+    Client *lastJob;
+    bool running;
+    
+} Watcher;
+
+/** This function free all the memory for a client and closes its socket, which also takes
+    it out of the shard's epoll.
+    @param *shard pointer to the client's shard.
+    @param *client pointer to the client.
+*/
+static void closeClient(Shard *shard, Client *client) 
+{
+    // The watcher still has a busy client, so it's only hung up on for now, and freed
+    // once its job is finished.
+    if (client->busy) {
+        close(client->fd);
+        client->fd = -1;
+        return;
+    }
+    
+    // Take it out of the shard's list.
+    if (client->prev != NULL) {
+        client->prev->next = client->next;
+    }
+    else {
+        shard->clients = client->next;
+    }
+    if (client->next != NULL) {
+        client->next->prev = client->prev;
+    }
+    if (client->fd >= 0) {
+        close(client->fd);
+    }
+    freeReader(client->reader);
+    freeOutput(client->out);
+    freeCommandState(client->state);
+    free(client);
+}
+
+/** This function writes as much of the client's output as the socket takes without
+    blocking. Once it is all written, a buffer that grew for a big response goes back to
+    the starting size.
+    @param *client pointer to the client.
+    @return false if the client can't be written to anymore.
+*/
+static bool sendOutput(Client *client) 
+{
+    Output *out = client->out;
+    while (client->sent < out->len) {
+        ssize_t n = write(client->fd, out->buffer + client->sent, out->len - client->sent);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        // The rest waits until the socket has room.
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        client->sent += n;
+    }
+    
+    // Everything was written, so the buffer is empty again.
+    out->len = 0;
+    client->sent = 0;
+    if (out->capacity > OUTPUT_BLOCK) {
+        out->capacity = CLIENT_BUFFER;
+        out->buffer = (char *)realloc(out->buffer, out->capacity);
+    }
+    return true;
+}
+
+/** This function hands a client's job to the watcher thread. The client is busy until
+    the watcher gives it back to the client's shard.
+    @param *watcher pointer to the watcher.
+    @param *client pointer to the client.
+*/
+static void submitJob(Watcher *watcher, Client *client) 
+{
+    client->busy = true;
+    client->nextJob = NULL;
+    pthread_mutex_lock(&watcher->lock);
+    if (watcher->jobs == NULL) {
+        watcher->jobs = client;
+    }
+    else {
+        watcher->lastJob->nextJob = client;
+    }
+    watcher->lastJob = client;
+    pthread_mutex_unlock(&watcher->lock);
+    
+    // Like a wakeup, several requests before the watcher gets to them are just one.
+    uint64_t one = 1;
+    write(watcher->requests, &one, sizeof(one));
+}
+
+/** This function runs the commands that are already in the client's buffer. Several
+    commands can come in one read, and they are all run, unless the responses pile up
+    faster than the client takes them, in which case the rest wait for the output. A
+    reload or load is handed to the watcher, and the rest wait for it to finish.
+    @param *client pointer to the client.
+    @return true if commands could be left waiting for the output.
+*/
+static bool runClient(Client *client) 
+{
+    while (!client->done && !client->busy) {
+        if (client->out->len - client->sent >= OUTPUT_BLOCK) {
+            return true;
+        }
+        char *input = bufferedLine(client->reader, NULL);
+        if (input == NULL) {
+            // A command too long to be one is thrown away along with the client.
+            LineReader *reader = client->reader;
+            if (reader->end - reader->start > CLIENT_LINE_MAX) {
+                putText(client->out, "Invalid command\n");
+                reader->start = reader->end;
+                client->done = true;
+                return false;
+            }
+            // A client that hung up is done once the last of its commands has run.
+            client->done = reader->eof;
+            return false;
+        }
+        // Each command is followed by the prompt for the next one, except quit. A command
+        // that reads course files gets it once it's finished.
+        if (!runCommand(client->state, input, client->out)) {
+            client->done = true;
+        }
+        else if (client->state->job != JOB_NONE) {
+            submitJob(client->shard->watcher, client);
+        }
+        else {
+            putText(client->out, "cmd> ");
+        }
+    }
+    return false;
+}
+
+/** This function handles what epoll reported for a client: reads what it sent, runs its
+    commands and writes the responses. Then the shard watches the socket for whatever
+    the client needs next, room to write responses that are waiting or more commands.
+    @param *shard pointer to the client's shard.
+    @param *client pointer to the client.
+    @param events the events epoll reported.
+*/
+static void handleClient(Shard *shard, Client *client, uint32_t events) 
+{
+    if (events & EPOLLERR) {
+        closeClient(shard, client);
+        return;
+    }
+    
+    // One read per event, epoll reports the socket again if there is more.
+    if (events & (EPOLLIN | EPOLLHUP)) {
+        fillReader(client->reader);
+    }
+    // Run commands and write responses until we run out of commands, or the socket
+    // runs out of room for the responses.
+    bool more;
+    do {
+        more = runClient(client);
+        if (!sendOutput(client)) {
+            closeClient(shard, client);
+            return;
+        }
+    } while (more && client->out->len == 0);
+    
+    // A client that is done is closed once it has all of its responses.
+    bool waiting = client->out->len > 0;
+    if (client->done && !waiting) {
+        closeClient(shard, client);
+        return;
+    }
+    
+    // Stop reading commands while responses are waiting, so a client that doesn't read
+    // them can't make them pile up. A busy client has nothing to do until its job is
+    // finished, so unless it has responses waiting, its socket is out of epoll until then.
+    uint32_t wanted = waiting ? EPOLLOUT : client->busy ? 0 : EPOLLIN;
+    if (wanted != client->events) {
+        struct epoll_event event = { .events = wanted, .data.ptr = client };
+        int op = wanted == 0 ? EPOLL_CTL_DEL : client->events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        epoll_ctl(shard->epoll, op, client->fd, &event);
+        client->events = wanted;
+    }
+}
+
+/** This function accepts every connection waiting on the listening socket and adds them
+    to the shard as new clients, greeting each with a prompt.
+    @param *shard pointer to the shard.
+*/
+static void acceptClients(Shard *shard) 
+{
+    while (1) {
+        int fd = accept4(shard->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            // A client that gave up before we got to it isn't a problem. Anything else,
+            // like nothing left to accept or running out of descriptors, waits until
+            // epoll reports the socket again.
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            return;
+        }
+        
+        Client *client = (Client *)malloc(sizeof(Client));
+        client->shard = shard;
+        client->fd = fd;
+        client->reader = makeSizedReader(fd, CLIENT_BUFFER);
+        client->out = makeSizedOutput(-1, CLIENT_BUFFER);
+        client->sent = 0;
+        client->done = false;
+        client->events = EPOLLIN;
+        client->state = makeCommandState(shard->live);
+        client->state->handOff = shard->watcher->running;
+        client->busy = false;
+        client->prev = NULL;
+        client->next = shard->clients;
+        if (shard->clients != NULL) {
+            shard->clients->prev = client;
+        }
+        shard->clients = client;
+        
+        // The client sees the first prompt as soon as it connects.
+        putText(client->out, "cmd> ");
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = client };
+        if (epoll_ctl(shard->epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            closeClient(shard, client);
+            continue;
+        }
+        handleClient(shard, client, 0);
+    }
+}
+
+/** This function finishes the commands of the clients whose jobs the watcher gave back,
+    and runs the commands they sent meanwhile.
+    @param *shard pointer to the shard.
+*/
+static void finishClients(Shard *shard) 
+{
+    pthread_mutex_lock(&shard->watcher->lock);
+    Client *client = shard->finished;
+    shard->finished = NULL;
+    pthread_mutex_unlock(&shard->watcher->lock);
+    
+    while (client != NULL) {
+        Client *next = client->nextJob;
+        client->busy = false;
+        // A client that hung up while it was busy can be freed now.
+        if (client->fd < 0) {
+            closeClient(shard, client);
+        }
+        else {
+            finishJob(client->state, client->status, client->failed, client->out);
+            putText(client->out, "cmd> ");
+            handleClient(shard, client, 0);
+        }
+        client = next;
+    }
+}
+
+/** This function finishes the clients whose jobs are done, then moves every client of the
+    shard to the newest catalog, so the old one can be freed without waiting for idle
+    clients to send a command.
+    @param *shard pointer to the shard.
+*/
+static void refreshClients(Shard *shard) 
+{
+    // The eventfd is read first, so a job finished after this wakes the shard again.
+    uint64_t count;
+    if (read(shard->wakeup, &count, sizeof(count)) < 0) {
+        return;
+    }
+    finishClients(shard);
+    for (Client *client = shard->clients; client != NULL; client = client->next) {
+        refreshCommandState(client->state);
+    }
+}
+
+/** This function is the start routine for the shard threads, the shard's event loop.
+    @param *arg pointer to the shard.
+    @return NULL if the shard's epoll stops working.
+*/
+static void *shardThread(void *arg) 
+{
+    Shard *shard = (Shard *)arg;
+    struct epoll_event events[SHARD_EVENTS];
+    while (1) {
+        int n = epoll_wait(shard->epoll, events, SHARD_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NULL;
+        }
+        for (int i = 0; i < n; i++) {
+            // The listening socket is the only thing in epoll without a client, and the
+            // wakeup eventfd points at the shard itself.
+            if (events[i].data.ptr == NULL) {
+                acceptClients(shard);
+            }
+            else if (events[i].data.ptr == shard) {
+                refreshClients(shard);
+            }
+            else {
+                handleClient(shard, events[i].data.ptr, events[i].events);
+            }
+        }
+    }
+}
+
+/** This function gives the part of a path after the last slash.
+    @param *path the path.
+    @return a pointer to the file's name in the path.
+*/
+static char const *baseName(char const *path) 
+{
+    char const *slash = strrchr(path, '/');
+    return slash == NULL ? path : slash + 1;
+}
+
+/** This function sets up the watcher's inotify instance to watch the directories the
+    course files are in. Watching the directories instead of the files sees a file that
+    is replaced by renaming a new one over it, the way most editors and tools save.
+    @param *watcher pointer to the watcher.
+*/
+static void watchFiles(Watcher *watcher) 
+{
+    watcher->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher->inotify < 0) {
+        return;
+    }
+    for (int i = 0; i < watcher->live->count; i++) {
+        // Everything up to the last slash is the directory, or it's the current one.
+        char const *file = watcher->live->filenames[i];
+        char const *name = baseName(file);
+        char dir[PATH_MAX_LEN];
+        if (name == file) {
+            strcpy(dir, ".");
+        }
+        else if (name - file < PATH_MAX_LEN) {
+            memcpy(dir, file, name - file);
+            dir[name - file] = '\0';
+        }
+        else {
+            continue;
+        }
+        // Watching the same directory twice just gives back the same watch.
+        inotify_add_watch(watcher->inotify, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+    }
+}
+
+/** This function reads the waiting inotify events.
+    @param *watcher pointer to the watcher.
+    @return true if one of them was about a course file.
+*/
+static bool courseFileChanged(Watcher *watcher) 
+{
+    // Events have to be read into a buffer lined up for them.
+    char buffer[INOTIFY_BUFFER] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+    ssize_t n;
+    while ((n = read(watcher->inotify, buffer, sizeof(buffer))) > 0) {
+        for (char *next = buffer; next < buffer + n; ) {
+            struct inotify_event *event = (struct inotify_event *)next;
+            // Loaded files can be added to the list meanwhile, so hold it still.
+            pthread_mutex_lock(&watcher->live->reloading);
+            for (int i = 0; event->len > 0 && i < watcher->live->count; i++) {
+                if (strcmp(event->name, baseName(watcher->live->filenames[i])) == 0) {
+                    changed = true;
+                }
+            }
+            pthread_mutex_unlock(&watcher->live->reloading);
+            next += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
+
+/** This function is called whenever a new catalog is published, either by a reload or by
+    a client loading a course file, and wakes up every shard to move its clients to it.
+    @param *arg pointer to the watcher.
+*/
+static void wakeShards(void *arg) 
+{
+    Watcher *watcher = (Watcher *)arg;
+    
+    // A shard that hasn't gotten to an earlier wakeup yet will see this catalog too.
+    uint64_t one = 1;
+    for (int i = 0; i < watcher->count; i++) {
+        write(watcher->shards[i].wakeup, &one, sizeof(one));
+    }
+}
+
+/** This function runs the jobs clients handed to the watcher, in the order they were
+    handed over, and gives each client back to its shard once its job is done.
+    @param *watcher pointer to the watcher.
+*/
+static void runJobs(Watcher *watcher) 
+{
+    while (1) {
+        pthread_mutex_lock(&watcher->lock);
+        Client *client = watcher->jobs;
+        if (client != NULL) {
+            watcher->jobs = client->nextJob;
+        }
+        pthread_mutex_unlock(&watcher->lock);
+        if (client == NULL) {
+            return;
+        }
+        
+        // The shard leaves a busy client alone, so its state is the watcher's for now.
+        client->status = runJob(client->state, &client->failed);
+        Shard *shard = client->shard;
+        pthread_mutex_lock(&watcher->lock);
+        client->nextJob = shard->finished;
+        shard->finished = client;
+        pthread_mutex_unlock(&watcher->lock);
+        uint64_t one = 1;
+        write(shard->wakeup, &one, sizeof(one));
+    }
+}
+
+/** This function is the start routine for the watcher thread. It waits for a course
+    file to change or for a client's reload or load, then builds a new catalog on this
+    thread while the shards keep serving the old one. Once the new catalog is published,
+    every shard is woken up to move its clients to it.
+    @param *arg pointer to the watcher.
+    @return NULL if it can't wait anymore.
+*/
+static void *watcherThread(void *arg) 
+{
+    Watcher *watcher = (Watcher *)arg;
+    struct pollfd waits[] = { { watcher->requests, POLLIN, 0 }, { watcher->inotify, POLLIN, 0 } };
+    int waitCount = watcher->inotify < 0 ? 1 : 2;
+    while (1) {
+        if (poll(waits, waitCount, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NULL;
+        }
+        
+        // Clients' jobs run right away, and their clients hear how they went.
+        uint64_t requests;
+        if ((waits[0].revents & POLLIN) && read(watcher->requests, &requests, sizeof(requests)) > 0) {
+            runJobs(watcher);
+        }
+        
+        // A change only reloads if it was to a course file.
+        if (waitCount == 1 || !(waits[1].revents & POLLIN) || !courseFileChanged(watcher)) {
+            continue;
+        }
+        
+        // Files are often written a piece at a time, so wait for them to settle down.
+        while (waitCount > 1 && poll(&waits[1], 1, RELOAD_DELAY) > 0) {
+            courseFileChanged(watcher);
+        }
+        
+        // A bad file leaves the old catalog in place until the file is fixed.
+        // The shards are woken up when the new catalog is published.
+        char const *failed;
+        LoadStatus status = reloadCatalog(watcher->live, &failed);
+        if (status == LOAD_CANT_OPEN) {
+            fprintf(stderr, "Can't open file: %s\n", failed);
+        }
+        else if (status == LOAD_INVALID) {
+            fprintf(stderr, "Invalid course file: %s\n", failed);
+        }
+    }
+}
+
+bool serveCatalog(LiveCatalog *live, char const *path) 
+{
+    // The path has to fit in the socket address.
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    strcpy(addr.sun_path, path);
+    
+    // Replace whatever socket an earlier server left at the path, and start listening.
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        return false;
+    }
+    unlink(path);
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || 
+        listen(listener, LISTEN_BACKLOG) != 0) {
+        close(listener);
+        return false;
+    }
+    
+    // A client hanging up while we write to it shouldn't kill the server, the write just
+    // fails and the connection is closed.
+    signal(SIGPIPE, SIG_IGN);
+    
+    // Every client needs a descriptor, so allow as many as we are allowed to ask for.
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    
+    // One shard for each core. Every shard watches the listening socket, but exclusively,
+    // so a new connection only wakes up one of them.
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int count = cores < 1 ? 1 : (int)cores;
+    Shard *shards = (Shard *)malloc(count * sizeof(Shard));
+    int ready = 0;
+    while (ready < count) {
+        Shard *shard = &shards[ready];
+        shard->live = live;
+        shard->listener = listener;
+        shard->clients = NULL;
+        shard->finished = NULL;
+        shard->epoll = epoll_create1(EPOLL_CLOEXEC);
+        shard->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        struct epoll_event event = { .events = EPOLLIN | EPOLLEXCLUSIVE, .data.ptr = NULL };
+        struct epoll_event wakeup = { .events = EPOLLIN, .data.ptr = shard };
+        if (shard->epoll < 0 || shard->wakeup < 0 || 
+            epoll_ctl(shard->epoll, EPOLL_CTL_ADD, listener, &event) != 0 ||
+            epoll_ctl(shard->epoll, EPOLL_CTL_ADD, shard->wakeup, &wakeup) != 0) {
+            break;
+        }
+        ready++;
+    }
+    
+    // From here on clients on different shards read the catalog at the same time, so
+    // loaded courses go into a new snapshot, and every new snapshot wakes up the shards.
+    // They need to be ready for that before any of them starts.
+    Watcher watcher = { live, shards, ready, -1, eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) };
+    pthread_mutex_init(&watcher.lock, NULL);
+    watcher.jobs = watcher.lastJob = NULL;
+    watcher.running = false;
+    for (int i = 0; i < ready; i++) {
+        shards[i].watcher = &watcher;
+    }
+    live->concurrent = true;
+    live->published = wakeShards;
+    live->publishedArg = &watcher;
+    
+    // The watcher reloads the catalog when a course file changes, and runs the reload and
+    // load commands of the clients, so a shard never waits on reading course files. If
+    // it can't start, they run right away on the client's shard instead. Shards read
+    // whether it's running without locking, so it's set before they start.
+    watchFiles(&watcher);
+    pthread_t watcherId;
+    if (watcher.requests >= 0 && pthread_create(&watcherId, NULL, watcherThread, &watcher) == 0) {
+        watcher.running = true;
+    }
+    int started = 0;
+    while (started < ready && 
+           pthread_create(&shards[started].thread, NULL, shardThread, &shards[started]) == 0) {
+        started++;
+    }
+    
+    // The shards only stop if epoll stops working.
+    for (int i = 0; i < started; i++) {
+        pthread_join(shards[i].thread, NULL);
+    }
+    live->published = NULL;
+    free(shards);
+    close(listener);
+    unlink(path);
+    
+    return false;
+}
@@ -0,0 +1,52 @@
+/** @file server.h
+    @author Huy Nguyen (hqnguyen)
+    This is the header file for the component that serves the catalog to clients over a
+    Unix domain socket.
+*/
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+
+#include "snapshot.h"
+
+/** Number of connections waiting to be accepted that the socket queues up */
+#define LISTEN_BACKLOG 1024
+
+/** Number of events a shard takes from epoll at a time */
+#define SHARD_EVENTS 64
+
+/** Starting size of a client's command and output buffers. Most clients are idle most of
+    the time, so they start small and only grow for the commands that need it. */
+#define CLIENT_BUFFER 512
+
+/** Longest command a client can send, in bytes. A client that sends more than this without
+    ending the line gets an invalid command and is disconnected, so it can't make its
+    command buffer grow without end. */
+#define CLIENT_LINE_MAX 65536
+
+/** Milliseconds the course files have to go without changing before they are reloaded */
+#define RELOAD_DELAY 100
+
+/** Bytes of inotify events read at a time */
+#define INOTIFY_BUFFER 4096
+
+/** Longest directory name of a course file that can be watched */
+#define PATH_MAX_LEN 4096
+
+/** This function serves the catalog over a Unix domain socket at the given path, which is
+    replaced if it already exists. Each connection is a client typing commands just like
+    on standard input, with its own schedules. Connections are spread over shards, one
+    for each core, and each shard is a thread running an epoll event loop over its
+    clients' non-blocking sockets. The shards read the current snapshot of the catalog
+    without locking, and another thread reloads the catalog whenever a course file
+    changes. The reload and load commands read course files on that thread too, so the
+    shard keeps serving its other clients, and the client hears back once it's done.
+    @param *live pointer to the live catalog to serve.
+    @param *path the path of the socket.
+    @return false if the socket couldn't be set up or stops working, otherwise it
+            serves forever.
+*/
+bool serveCatalog(LiveCatalog *live, char const *path);
+
+#endif
@@ -0,0 +1,197 @@
+/** @file snapshot.c
+    @author Huy Nguyen (hqnguyen)
+    This component lets the catalog be reloaded from its course files while it is being
+    used. Each version of the catalog is a snapshot that readers hold a reference to.
+    A reload builds a whole new catalog on the side and swaps it in, and an old catalog
+    is freed once its last reader lets go of it.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "snapshot.h"
+#include "image.h"
+#include "input.h"
+
+/** This function dynamically allocate memory for a snapshot of the given catalog, with
+    one reference for the live catalog to hold.
+    @param *catalog pointer to the catalog.
+    @param version the version of the catalog.
+    @param lineage the version of the full reload the catalog comes from.
+    @return a pointer to the new snapshot.
+*/
+static Snapshot *makeSnapshot( Catalog *catalog, int version, int lineage ) 
+{
+    Snapshot *snapshot = (Snapshot *)malloc(sizeof(Snapshot));
+    snapshot->catalog = catalog;
+    snapshot->version = version;
+    snapshot->lineage = lineage;
+    snapshot->refs = 1;
+    return snapshot;
+}
+
+/** This function adds a course file to the files the catalog is reloaded from.
+    @param *live pointer to the live catalog.
+    @param *filename pointer to the name of the file, which is copied.
+*/
+static void addFilename( LiveCatalog *live, char const *filename ) 
+{
+    // Resizable array of file names.
+    if (live->count >= live->capacity) {
+        live->capacity = live->capacity * DOUBLE_ARRAY + 1;
+        live->filenames = (char **)realloc(live->filenames, live->capacity * sizeof(char *));
+    }
+    live->filenames[live->count] = (char *)malloc(strlen(filename) + 1);
+    strcpy(live->filenames[live->count], filename);
+    live->count++;
+}
+
+/** This function publishes a new catalog as the current snapshot, then lets whoever is
+    interested know. Reloading must be held.
+    @param *live pointer to the live catalog.
+    @param *catalog pointer to the new catalog.
+    @param lineage the version of the full reload the catalog comes from, or -1 if this
+                   is a full reload.
+*/
+static void publishCatalog( LiveCatalog *live, Catalog *catalog, int lineage ) 
+{
+    // Swap in the new snapshot. The version changes last, so anyone who sees the new
+    // version finds the new snapshot when they acquire it.
+    pthread_mutex_lock(&live->lock);
+    Snapshot *old = live->current;
+    int version = old->version + 1;
+    live->current = makeSnapshot(catalog, version, lineage < 0 ? version : lineage);
+    __atomic_store_n(&live->version, version, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&live->lock);
+    
+    // The live catalog's reference to the old snapshot goes away, readers still using it
+    // keep it around until they are done.
+    releaseSnapshot(old);
+    if (live->published != NULL) {
+        live->published(live->publishedArg);
+    }
+}
+
+LiveCatalog *makeLiveCatalog( Catalog *catalog, char const * const *filenames, int count, int workers ) 
+{
+    LiveCatalog *live = (LiveCatalog *)malloc(sizeof(LiveCatalog));
+    live->current = makeSnapshot(catalog, 0, 0);
+    live->version = 0;
+    pthread_mutex_init(&live->lock, NULL);
+    pthread_mutex_init(&live->reloading, NULL);
+    live->filenames = NULL;
+    live->count = 0;
+    live->capacity = 0;
+    for (int i = 0; i < count; i++) {
+        addFilename(live, filenames[i]);
+    }
+    live->base = count;
+    live->workers = workers;
+    live->concurrent = false;
+    live->published = NULL;
+    live->publishedArg = NULL;
+    return live;
+}
+
+void freeLiveCatalog( LiveCatalog *live ) 
+{
+    releaseSnapshot(live->current);
+    for (int i = 0; i < live->count; i++) {
+        free(live->filenames[i]);
+    }
+    free(live->filenames);
+    pthread_mutex_destroy(&live->lock);
+    pthread_mutex_destroy(&live->reloading);
+    free(live);
+}
+
+Snapshot *acquireSnapshot( LiveCatalog *live ) 
+{
+    // The lock keeps the snapshot from being replaced and released before we count
+    // our reference to it.
+    pthread_mutex_lock(&live->lock);
+    Snapshot *snapshot = live->current;
+    __atomic_add_fetch(&snapshot->refs, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&live->lock);
+    return snapshot;
+}
+
+void releaseSnapshot( Snapshot *snapshot ) 
+{
+    // Whoever lets go last frees it, after everyone else's reads of it are done.
+    if (__atomic_sub_fetch(&snapshot->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        freeCatalog(snapshot->catalog);
+        free(snapshot);
+    }
+}
+
+bool isCurrent( LiveCatalog *live, Snapshot const *snapshot ) 
+{
+    return __atomic_load_n(&live->version, __ATOMIC_ACQUIRE) == snapshot->version;
+}
+
+LoadStatus reloadCatalog( LiveCatalog *live, char const **failed ) 
+{
+    pthread_mutex_lock(&live->reloading);
+    
+    // Build the new catalog the same way the first one was, a single compiled image is
+    // mapped and anything else is read as course files.
+    Catalog *catalog = NULL;
+    LoadStatus status = LOAD_OK;
+    if (live->base == 1) {
+        catalog = loadImage(live->filenames[0]);
+    }
+    if (catalog == NULL) {
+        catalog = makeCatalog();
+        int index;
+        status = loadCourses(catalog, (char const * const *)live->filenames, live->base, live->workers, &index);
+        if (status != LOAD_OK) {
+            *failed = live->filenames[index];
+        }
+        buildViews(catalog);
+    }
+    // Then add the files that were added to it since.
+    for (int i = live->base; i < live->count && status == LOAD_OK; i++) {
+        status = appendCourses(catalog, live->filenames[i]);
+        *failed = live->filenames[i];
+    }
+    
+    // A bad file leaves the current catalog as it is.
+    if (status != LOAD_OK) {
+        freeCatalog(catalog);
+    }
+    else {
+        publishCatalog(live, catalog, -1);
+    }
+    pthread_mutex_unlock(&live->reloading);
+    return status;
+}
+
+LoadStatus appendCatalog( LiveCatalog *live, char const *filename ) 
+{
+    pthread_mutex_lock(&live->reloading);
+    
+    // Nothing else replaces the current snapshot while reloading is held.
+    Snapshot *current = live->current;
+    LoadStatus status;
+    if (live->concurrent) {
+        // Readers never see a catalog change, they see a new one with more courses.
+        Catalog *catalog = copyCatalog(current->catalog);
+        status = appendCourses(catalog, filename);
+        if (status != LOAD_OK) {
+            freeCatalog(catalog);
+        }
+        else {
+            publishCatalog(live, catalog, current->lineage);
+        }
+    }
+    else {
+        status = appendCourses(current->catalog, filename);
+    }
+    if (status == LOAD_OK) {
+        addFilename(live, filename);
+    }
+    
+    pthread_mutex_unlock(&live->reloading);
+    return status;
+}
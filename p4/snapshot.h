@@ -0,0 +1,111 @@
+/** @file snapshot.h
+    @author Huy Nguyen (hqnguyen)
+    This is the header file for the component that lets the catalog be reloaded from its
+    course files while it is being used.
+*/
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "catalog.h"
+
+/** The snapshot struct is one version of the catalog. A catalog never changes once it is
+    published, so anyone holding a reference to a snapshot can read its catalog without
+    locking. Refs counts the references, and the catalog is freed when the last one is
+    released. Lineage is the version of the last full reload the catalog comes from.
+    Versions of the same lineage only add courses to it, and share its courses.
+*/
+typedef struct {
+    Catalog *catalog;
+    int version;
+    int lineage;
+    int refs;
+    
+} Snapshot;
+
+/** The live catalog struct holds the current snapshot of the catalog, and how to build a
+    new one from the course files. Current holds a reference of its own, and lock is only
+    held to take a reference to the current snapshot or replace it, while version can be
+    read at any time to see if a snapshot is still current. Reloading is held while a new
+    catalog is built or courses are added, so only one change is made at a time.
+    Filenames holds the course files, the first base of them from the command line and
+    the rest added later by appendCatalog(). Concurrent is set when other threads may be
+    reading the catalog, so courses are added to a copy of it instead of the catalog
+    itself. Published, if it isn't NULL, is called with publishedArg after every new
+    snapshot.
+*/
+typedef struct {
+    Snapshot *current;
+    int version;
+    pthread_mutex_t lock;
+    pthread_mutex_t reloading;
+    
+    char **filenames;
+    int count;
+    int capacity;
+    int base;
+    int workers;
+    bool concurrent;
+    void (*published)( void *arg );
+    void *publishedArg;
+    
+} LiveCatalog;
+
+/** This function dynamically allocate memory for a live catalog that starts out with
+    the given catalog as its first version.
+    @param *catalog pointer to the catalog, already built from the course files.
+    @param *filenames array of pointers to the course files to reload from.
+    @param count the number of course files.
+    @param workers the number of threads to read the course files with.
+    @return a pointer to the new live catalog.
+*/
+LiveCatalog *makeLiveCatalog( Catalog *catalog, char const * const *filenames, int count, int workers );
+
+/** This function free the live catalog, and its current catalog once no one else holds a
+    reference to it.
+    @param *live pointer to the live catalog.
+*/
+void freeLiveCatalog( LiveCatalog *live );
+
+/** This function takes a reference to the current snapshot.
+    @param *live pointer to the live catalog.
+    @return a pointer to the snapshot, to be released when it's no longer needed.
+*/
+Snapshot *acquireSnapshot( LiveCatalog *live );
+
+/** This function releases a reference to a snapshot, freeing its catalog if it was the
+    last one.
+    @param *snapshot pointer to the snapshot.
+*/
+void releaseSnapshot( Snapshot *snapshot );
+
+/** This function checks whether a snapshot is still the current one, without locking.
+    @param *live pointer to the live catalog.
+    @param *snapshot pointer to the snapshot.
+    @return true if there is no newer snapshot.
+*/
+bool isCurrent( LiveCatalog *live, Snapshot const *snapshot );
+
+/** This function builds a new catalog from the course files and publishes it as the
+    current snapshot. Readers of the old snapshot keep using it until they release it.
+    If the files can't be read, the current snapshot stays as it is.
+    @param *live pointer to the live catalog.
+    @param **failed pointer to where the name of the file that had a problem is stored.
+    @return LOAD_OK if the new catalog was published, or what went wrong.
+*/
+LoadStatus reloadCatalog( LiveCatalog *live, char const **failed );
+
+/** This function adds the courses from another course file to the catalog, and to the
+    files it is reloaded from. When other threads may be reading the catalog, the courses
+    are added to a copy that shares the old catalog's courses, which is published as a
+    new snapshot of the same lineage. Otherwise they are added to the catalog itself. If
+    the file can't be read, the catalog stays as it is.
+    @param *live pointer to the live catalog.
+    @param *filename pointer to the course file.
+    @return LOAD_OK if the courses were added, or what went wrong.
+*/
+LoadStatus appendCatalog( LiveCatalog *live, char const *filename );
+
+#endif
@@ -0,0 +1,174 @@
+/** @file solver.c
+    @author Huy Nguyen (hqnguyen)
+    This component searches for the best schedules that can be made from a wishlist of
+    courses. Two courses conflict only when they share a timeslot, so the search goes
+    through the free timeslots one at a time, picking one of the courses wished for in
+    that timeslot or leaving it free.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "solver.h"
+
+/** The search struct holds the state of a search. The timeslots that have courses to
+    choose from are searched in order of the highest priority in each, and best[d] is
+    the highest priority of a course in the timeslot at depth d. Its courses are choices[start[d]] up to choices[start[d + 1]], highest
+    priority first. Current is the schedule being built and priority what the courses
+    added to it are worth, and the best schedules found so far are in solutions.
+*/
+typedef struct {
+    int depths;
+    int best[TIMESLOT_COUNT];
+    int start[TIMESLOT_COUNT + 1];
+    Wish const **choices;
+
+    Schedule current;
+    int priority;
+
+    Solution *solutions;
+    int found;
+    int top;
+
+} Search;
+
+/** Comparison function used to order the courses wished for in a timeslot, by priority
+    from high to low and then by where they are on the wishlist.
+    @param *va a constant void pointer to a wish pointer.
+    @param *vb another constant void pointer to a wish pointer.
+    @return -1 if the first wish should be tried before the second one and 1 otherwise.
+*/
+static int compareWish( void const *va, void const *vb )
+{
+    Wish const *a = *(Wish const **)va;
+    Wish const *b = *(Wish const **)vb;
+    if (a->priority != b->priority) {
+        return a->priority > b->priority ? ORDER_BEFORE : ORDER_AFTER;
+    }
+    return a < b ? ORDER_BEFORE : a > b ? ORDER_AFTER : EQUAL;
+}
+
+/** This function keeps the schedule being built if it's one of the best so far.
+    @param *search pointer to the search.
+*/
+static void keepSolution( Search *search )
+{
+    // Schedules go after every schedule that's at least as good, so the first one
+    // found of the same priority stays ahead.
+    int at = search->found;
+    while (at > 0 && search->solutions[at - 1].priority < search->priority) {
+        at--;
+    }
+    if (at == search->top) {
+        return;
+    }
+    int moved = search->found < search->top ? search->found : search->top - 1;
+    memmove(search->solutions + at + 1, search->solutions + at, (moved - at) * sizeof(Solution));
+    search->solutions[at].schedule = search->current;
+    search->solutions[at].priority = search->priority;
+    if (search->found < search->top) {
+        search->found++;
+    }
+}
+
+/** This function searches the timeslots from a depth on, with the courses picked for the
+    timeslots before it already in the schedule being built.
+    @param *search pointer to the search.
+    @param depth the depth of the next timeslot to pick a course for.
+*/
+static void searchFrom( Search *search, int depth )
+{
+    Schedule *current = &search->current;
+    int room = SCHEDULE_MAX_LEN - current->size;
+    if (depth == search->depths || room == 0) {
+        keepSolution(search);
+        return;
+    }
+
+    // At best, the room left is filled with the best course from each of the next
+    // timeslots, which have the highest priorities left. Once there are enough
+    // schedules, a branch has to beat the worst of them to be worth searching.
+    if (search->found == search->top) {
+        int bound = search->priority;
+        for (int d = depth; d < search->depths && d < depth + room; d++) {
+            bound += search->best[d];
+        }
+        if (bound <= search->solutions[search->top - 1].priority) {
+            return;
+        }
+    }
+
+    for (int i = search->start[depth]; i < search->start[depth + 1]; i++) {
+        Wish const *wish = search->choices[i];
+        addToSchedule(current, wish->course);
+        search->priority += wish->priority;
+        searchFrom(search, depth + 1);
+        search->priority -= wish->priority;
+        dropFromSchedule(current, wish->course);
+    }
+
+    // Leaving the timeslot free only makes a schedule that can't take more courses if
+    // the timeslots after it can still fill the room.
+    if (search->depths - depth - 1 >= room) {
+        searchFrom(search, depth + 1);
+    }
+}
+
+int solveSchedule( Schedule const *schedule, Wish const *wishes, int count, Solution *solutions, int top )
+{
+    Search search = { .depths = 0, .current = *schedule, .priority = 0,
+                      .solutions = solutions, .found = 0, .top = top };
+
+    // Courses in timeslots the schedule already uses can't be added, so only the
+    // rest are sorted into the timeslots they're in.
+    int slotCount[TIMESLOT_COUNT] = { 0 };
+    for (int i = 0; i < count; i++) {
+        if ((schedule->occupied & (1u << wishes[i].course->slot)) == 0) {
+            slotCount[wishes[i].course->slot]++;
+        }
+    }
+    int slotStart[TIMESLOT_COUNT + 1] = { 0 };
+    for (int s = 0; s < TIMESLOT_COUNT; s++) {
+        slotStart[s + 1] = slotStart[s] + slotCount[s];
+    }
+    Wish const **bySlot = (Wish const **) malloc((slotStart[TIMESLOT_COUNT] + 1) * sizeof(Wish const *));
+    int next[TIMESLOT_COUNT];
+    memcpy(next, slotStart, sizeof(next));
+    for (int i = 0; i < count; i++) {
+        if ((schedule->occupied & (1u << wishes[i].course->slot)) == 0) {
+            bySlot[next[wishes[i].course->slot]++] = wishes + i;
+        }
+    }
+
+    // Order the courses in each timeslot, then the timeslots by their best course, so
+    // the best schedules tend to be found first and the bound cuts off more.
+    int order[TIMESLOT_COUNT];
+    for (int s = 0; s < TIMESLOT_COUNT; s++) {
+        qsort(bySlot + slotStart[s], slotCount[s], sizeof(Wish const *), compareWish);
+        if (slotCount[s] == 0) {
+            continue;
+        }
+        int at = search.depths++;
+        int best = bySlot[slotStart[s]]->priority;
+        while (at > 0 && bySlot[slotStart[order[at - 1]]]->priority < best) {
+            order[at] = order[at - 1];
+            at--;
+        }
+        order[at] = s;
+    }
+
+    // Lay the choices out in the order of the search.
+    search.choices = (Wish const **) malloc((slotStart[TIMESLOT_COUNT] + 1) * sizeof(Wish const *));
+    for (int d = 0; d < search.depths; d++) {
+        int s = order[d];
+        search.best[d] = bySlot[slotStart[s]]->priority;
+        search.start[d + 1] = search.start[d] + slotCount[s];
+        memcpy(search.choices + search.start[d], bySlot + slotStart[s], slotCount[s] * sizeof(Wish const *));
+    }
+    free(bySlot);
+
+    searchFrom(&search, 0);
+    free(search.choices);
+    return search.found;
+}
@@ -0,0 +1,51 @@
+/** @file solver.h
+    @author Huy Nguyen (hqnguyen)
+    This is the header file for the component that builds the best schedules it can out
+    of a wishlist of courses, for the autoschedule command.
+*/
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "catalog.h"
+#include "student.h"
+
+/** Highest priority a course on a wishlist can be given */
+#define WISH_PRIORITY_MAX 100
+
+/** Most schedules autoschedule can be asked for */
+#define SOLUTIONS_MAX 10
+
+/** The wish struct is one course on a wishlist, with how much the student wants it. */
+typedef struct {
+    Course *course;
+    int priority;
+
+} Wish;
+
+/** The solution struct is a schedule the solver found, with the total priority of the
+    courses it added to the student's schedule.
+*/
+typedef struct {
+    Schedule schedule;
+    int priority;
+
+} Solution;
+
+/** This function finds the schedules with the highest total priority that can be made by
+    adding courses from a wishlist to a schedule. Only schedules that can't take another
+    course from the wishlist count, so no schedule found is just a part of another one.
+    Courses share a timeslot only if they conflict, so the search picks at most one
+    course for each timeslot the schedule has free, skipping any branch that can't beat
+    the schedules already found. Schedules with the same priority are kept in the order
+    they're found, and the search tries higher priority courses, then earlier ones on
+    the wishlist, first.
+    @param *schedule pointer to the student's schedule, which the courses are added to.
+    @param *wishes array of the courses on the wishlist, each course only once.
+    @param count the number of courses on the wishlist.
+    @param *solutions array where the schedules found are stored, best first.
+    @param top the most schedules to find, up to SOLUTIONS_MAX.
+    @return the number of schedules found, which is at least one.
+*/
+int solveSchedule( Schedule const *schedule, Wish const *wishes, int count, Solution *solutions, int top );
+
+#endif
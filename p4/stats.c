@@ -0,0 +1,382 @@
+/** @file stats.c
+    @author Huy Nguyen (hqnguyen)
+    This component contains functions for counting where a running schedule spends its
+    time and memory, and printing what it counted. Counters are updated with atomic adds,
+    so shards serving clients on different threads can all record into them at once.
+    Allocations are counted by wrapping malloc(), calloc(), realloc() and free() when
+    the program is linked with --wrap for each of them.
+*/
+
+// Needed for clock_gettime() and malloc_usable_size().
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+#include <pthread.h>
+
+#include "stats.h"
+#include "input.h"
+
+/** Nanoseconds in a second */
+#define NANOS 1000000000L
+
+/** Nanoseconds in a millisecond */
+#define NANOS_PER_MILLI 1000000L
+
+/** Nanoseconds in a microsecond */
+#define NANOS_PER_MICRO 1000L
+
+/** Longest number or time printed in a column */
+#define FIELD_LEN 32
+
+/** Width of the name column of the timer table */
+#define TIMER_NAME_WIDTH 16
+
+/** Width of the name column of the file table */
+#define FILE_NAME_WIDTH 24
+
+/** Width of the other columns */
+#define COLUMN_WIDTH 11
+
+/** Percent of the times that are at most the median */
+#define P50 50
+
+/** Percent of the times that are at most the 99th percentile */
+#define P99 99
+
+/** The histogram struct holds the times recorded for one timer. Bucket b counts the
+    times from 2^(b - 1) up to 2^b nanoseconds. Count is only filled in on copies, from
+    the buckets.
+*/
+typedef struct {
+    long count;
+    long total;
+    long max;
+    long buckets[HISTOGRAM_BUCKETS];
+
+} Histogram;
+
+/** The file stats struct holds the times recorded for one course file, over every time
+    it was loaded.
+*/
+typedef struct {
+    char *name;
+    long loads;
+    long courses;
+    long nanos[LOAD_PHASES];
+
+} FileStats;
+
+bool statsEnabled = false;
+
+/** The histogram for each timer. */
+static Histogram timers[TIMERS];
+
+/** What each timer is called when it's printed. */
+static char const *timerNames[TIMERS] = {
+    "list courses", "list names", "list department", "list timeslot", "list schedule",
+    "list query", "search", "add", "drop", "autoschedule", "student", "calendar", "reload",
+    "load", "stats", "quit", "invalid", "build views", "merge views"
+};
+
+/** What each load phase is called when it's printed. */
+static char const *phaseNames[LOAD_PHASES] = { "Read", "Parse", "Validate", "Insert" };
+
+/** The stats for each course file loaded, which is held still by filesLock. */
+static FileStats *files = NULL;
+static int fileCount = 0;
+static int fileCapacity = 0;
+static pthread_mutex_t filesLock = PTHREAD_MUTEX_INITIALIZER;
+
+/** Counts of allocations, reallocations and frees, the bytes asked for in all, and
+    the bytes allocated right now. */
+static long allocations = 0;
+static long reallocations = 0;
+static long frees = 0;
+static long allocatedBytes = 0;
+static long bytesInUse = 0;
+
+void enableStats()
+{
+    statsEnabled = true;
+}
+
+long statsNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * NANOS + ts.tv_nsec;
+}
+
+void recordTime(StatTimer timer, long start)
+{
+    if (start == 0) {
+        return;
+    }
+    long nanos = statsNow() - start;
+
+    // Bucket b holds the times with b significant bits.
+    int bucket = nanos > 0 ? (int)(sizeof(long) * 8) - __builtin_clzl(nanos) : 0;
+    if (bucket >= HISTOGRAM_BUCKETS) {
+        bucket = HISTOGRAM_BUCKETS - 1;
+    }
+    Histogram *histogram = &timers[timer];
+    __atomic_add_fetch(&histogram->total, nanos, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&histogram->buckets[bucket], 1, __ATOMIC_RELAXED);
+    long max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+    while (nanos > max && !__atomic_compare_exchange_n(&histogram->max, &max, nanos, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void recordLoad(char const *filename, long courses, long const nanos[LOAD_PHASES])
+{
+    if (!statsEnabled) {
+        return;
+    }
+    pthread_mutex_lock(&filesLock);
+
+    // Find the file's stats, or start them the first time it's loaded.
+    int i = 0;
+    while (i < fileCount && strcmp(files[i].name, filename) != 0) {
+        i++;
+    }
+    if (i == fileCount) {
+        if (fileCount >= fileCapacity) {
+            fileCapacity = fileCapacity == 0 ? INITIAL_CAPACITY : fileCapacity * DOUBLE_ARRAY;
+            files = (FileStats *)realloc(files, fileCapacity * sizeof(FileStats));
+        }
+        files[i].name = (char *)malloc(strlen(filename) + 1);
+        strcpy(files[i].name, filename);
+        files[i].loads = 0;
+        files[i].courses = 0;
+        memset(files[i].nanos, 0, sizeof(files[i].nanos));
+        fileCount++;
+    }
+
+    files[i].loads++;
+    files[i].courses += courses;
+    for (int p = 0; p < LOAD_PHASES; p++) {
+        files[i].nanos[p] += nanos[p];
+    }
+    pthread_mutex_unlock(&filesLock);
+}
+
+/** Helper method to write a time in the unit that suits it best.
+    @param *text pointer to where the time is written, with room for FIELD_LEN.
+    @param nanos the time in nanoseconds.
+*/
+static void formatTime(char *text, double nanos)
+{
+    if (nanos < NANOS_PER_MICRO) {
+        snprintf(text, FIELD_LEN, "%.0fns", nanos);
+    }
+    else if (nanos < NANOS_PER_MILLI) {
+        snprintf(text, FIELD_LEN, "%.1fus", nanos / NANOS_PER_MICRO);
+    }
+    else if (nanos < NANOS) {
+        snprintf(text, FIELD_LEN, "%.2fms", nanos / NANOS_PER_MILLI);
+    }
+    else {
+        snprintf(text, FIELD_LEN, "%.2fs", nanos / NANOS);
+    }
+}
+
+/** Helper method to print a time right aligned in a column.
+    @param *out pointer to the output.
+    @param nanos the time in nanoseconds.
+*/
+static void putTime(Output *out, double nanos)
+{
+    char text[FIELD_LEN];
+    formatTime(text, nanos);
+    putRight(out, text, COLUMN_WIDTH);
+}
+
+/** Helper method to print a number right aligned in a column.
+    @param *out pointer to the output.
+    @param value the number.
+*/
+static void putCount(Output *out, long value)
+{
+    char text[FIELD_LEN];
+    snprintf(text, FIELD_LEN, "%ld", value);
+    putRight(out, text, COLUMN_WIDTH);
+}
+
+/** Helper method to estimate a percentile of the times in a histogram, as the top of
+    the bucket it falls in, but never more than the longest time.
+    @param *histogram pointer to the histogram.
+    @param percent which percentile.
+    @return the estimated time in nanoseconds.
+*/
+static long percentile(Histogram const *histogram, int percent)
+{
+    long rank = (histogram->count * percent + 99) / 100;
+    long seen = 0;
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        seen += histogram->buckets[b];
+        if (seen >= rank) {
+            long top = 1L << b;
+            return top < histogram->max ? top : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+void printStats(Output *out, Catalog const *catalog)
+{
+    if (statsEnabled) {
+        // Every timer that has recorded something, with its latencies.
+        putLeft(out, "Operation", TIMER_NAME_WIDTH);
+        char const *columns[] = { "Count", "Mean", "p50", "p99", "Max" };
+        for (int c = 0; c < (int)(sizeof(columns) / sizeof(columns[0])); c++) {
+            putRight(out, columns[c], COLUMN_WIDTH);
+        }
+        putBytes(out, "\n", 1);
+        for (int t = 0; t < TIMERS; t++) {
+            // Take a copy, so the percentiles come from one set of counts even while
+            // other threads record.
+            Histogram histogram;
+            histogram.count = 0;
+            for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+                histogram.buckets[b] = __atomic_load_n(&timers[t].buckets[b], __ATOMIC_RELAXED);
+                histogram.count += histogram.buckets[b];
+            }
+            histogram.total = __atomic_load_n(&timers[t].total, __ATOMIC_RELAXED);
+            histogram.max = __atomic_load_n(&timers[t].max, __ATOMIC_RELAXED);
+            if (histogram.count == 0) {
+                continue;
+            }
+            putLeft(out, timerNames[t], TIMER_NAME_WIDTH);
+            putCount(out, histogram.count);
+            putTime(out, (double)histogram.total / histogram.count);
+            putTime(out, percentile(&histogram, P50));
+            putTime(out, percentile(&histogram, P99));
+            putTime(out, histogram.max);
+            putBytes(out, "\n", 1);
+        }
+
+        // Every course file loaded, with the time spent on each phase in all.
+        putBytes(out, "\n", 1);
+        putLeft(out, "File", FILE_NAME_WIDTH);
+        putRight(out, "Loads", COLUMN_WIDTH);
+        putRight(out, "Courses", COLUMN_WIDTH);
+        for (int p = 0; p < LOAD_PHASES; p++) {
+            putRight(out, phaseNames[p], COLUMN_WIDTH);
+        }
+        putBytes(out, "\n", 1);
+        pthread_mutex_lock(&filesLock);
+        for (int i = 0; i < fileCount; i++) {
+            putLeft(out, files[i].name, FILE_NAME_WIDTH);
+            putCount(out, files[i].loads);
+            putCount(out, files[i].courses);
+            for (int p = 0; p < LOAD_PHASES; p++) {
+                putTime(out, files[i].nanos[p]);
+            }
+            putBytes(out, "\n", 1);
+        }
+        pthread_mutex_unlock(&filesLock);
+
+        // Allocations made through the wrapped allocator, if it's wrapped.
+        char line[FIELD_LEN * 6];
+        snprintf(line, sizeof(line), "\nAllocations: %ld made, %ld resized, %ld freed, %ld bytes allocated, %ld bytes in use\n",
+                 __atomic_load_n(&allocations, __ATOMIC_RELAXED), __atomic_load_n(&reallocations, __ATOMIC_RELAXED),
+                 __atomic_load_n(&frees, __ATOMIC_RELAXED), __atomic_load_n(&allocatedBytes, __ATOMIC_RELAXED),
+                 __atomic_load_n(&bytesInUse, __ATOMIC_RELAXED));
+        putText(out, line);
+    }
+    else {
+        putText(out, "Statistics are off, start with --stats or set " STATS_VARIABLE " to collect them\n");
+    }
+
+    // How much memory the catalog takes up is worked out when it's asked for.
+    char line[FIELD_LEN * 2];
+    snprintf(line, sizeof(line), "Catalog: %d courses in %zu bytes\n", catalog->count, catalogSize(catalog));
+    putText(out, line);
+}
+
+/** The allocator functions being wrapped. */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+/** Helper method to count a new allocation.
+    @param *ptr pointer to the memory allocated, or NULL if it couldn't be.
+    @param size the bytes asked for.
+*/
+static void countAllocation(void *ptr, size_t size)
+{
+    if (ptr != NULL) {
+        __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&allocatedBytes, (long)size, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&bytesInUse, (long)malloc_usable_size(ptr), __ATOMIC_RELAXED);
+    }
+}
+
+/** This function is called instead of malloc(), when the program is linked to wrap it.
+    @param size the bytes to allocate.
+    @return a pointer to the memory.
+*/
+void *__wrap_malloc(size_t size)
+{
+    void *ptr = __real_malloc(size);
+    if (statsEnabled) {
+        countAllocation(ptr, size);
+    }
+    return ptr;
+}
+
+/** This function is called instead of calloc(), when the program is linked to wrap it.
+    @param count the number of elements.
+    @param size the size of each element.
+    @return a pointer to the zeroed memory.
+*/
+void *__wrap_calloc(size_t count, size_t size)
+{
+    void *ptr = __real_calloc(count, size);
+    if (statsEnabled) {
+        countAllocation(ptr, count * size);
+    }
+    return ptr;
+}
+
+/** This function is called instead of realloc(), when the program is linked to wrap it.
+    @param *ptr pointer to the memory to resize, or NULL to allocate new memory.
+    @param size the new size.
+    @return a pointer to the resized memory.
+*/
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    if (!statsEnabled) {
+        return __real_realloc(ptr, size);
+    }
+    if (ptr == NULL) {
+        ptr = __real_realloc(ptr, size);
+        countAllocation(ptr, size);
+        return ptr;
+    }
+    long before = (long)malloc_usable_size(ptr);
+    void *resized = __real_realloc(ptr, size);
+    if (resized != NULL) {
+        __atomic_add_fetch(&reallocations, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&allocatedBytes, (long)size, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&bytesInUse, (long)malloc_usable_size(resized) - before, __ATOMIC_RELAXED);
+    }
+    return resized;
+}
+
+/** This function is called instead of free(), when the program is linked to wrap it.
+    @param *ptr pointer to the memory to free.
+*/
+void __wrap_free(void *ptr)
+{
+    if (statsEnabled && ptr != NULL) {
+        __atomic_add_fetch(&frees, 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&bytesInUse, (long)malloc_usable_size(ptr), __ATOMIC_RELAXED);
+    }
+    __real_free(ptr);
+}
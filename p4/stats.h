@@ -0,0 +1,78 @@
+/** @file stats.h
+    @author Huy Nguyen (hqnguyen)
+    This is the header file for the component that counts where a running schedule spends
+    its time and memory: how long each phase of loading each course file takes, how long
+    each kind of command takes, and how much memory is allocated.
+*/
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "catalog.h"
+#include "output.h"
+
+/** Environment variable that turns on statistics and prints them at exit when it's set */
+#define STATS_VARIABLE "SCHEDULE_STATS"
+
+/** Number of buckets in a latency histogram. Bucket b counts times under 2^b nanoseconds
+    that didn't fit in the bucket before, and the last bucket counts everything longer. */
+#define HISTOGRAM_BUCKETS 40
+
+/** The phases of loading a course file. Read is opening and mapping the file, parse is
+    reading courses out of its lines and checking their fields, validate is checking
+    for duplicate courses and insert is adding the courses to the catalog's list and
+    index. A file that can't be mapped is read as it's parsed, so that's all parse. */
+typedef enum { PHASE_READ, PHASE_PARSE, PHASE_VALIDATE, PHASE_INSERT, LOAD_PHASES } LoadPhase;
+
+/** The things that are timed. Every command has its own timer, by which command it
+    turned out to be, and building or merging the views is timed apart from the files. */
+typedef enum {
+    TIMER_LIST_COURSES, TIMER_LIST_NAMES, TIMER_LIST_DEPARTMENT, TIMER_LIST_TIMESLOT,
+    TIMER_LIST_SCHEDULE, TIMER_LIST_QUERY, TIMER_SEARCH, TIMER_ADD, TIMER_DROP,
+    TIMER_AUTOSCHEDULE, TIMER_STUDENT, TIMER_CALENDAR, TIMER_RELOAD, TIMER_LOAD,
+    TIMER_STATS, TIMER_QUIT, TIMER_INVALID, TIMER_BUILD_VIEWS, TIMER_MERGE_VIEWS, TIMERS
+} StatTimer;
+
+/** Whether statistics are being collected. Everything that records one checks this
+    first, so with it off they cost a branch. */
+extern bool statsEnabled;
+
+/** This function starts collecting statistics.
+*/
+void enableStats();
+
+/** This function reads the clock, in nanoseconds.
+    @return the time from some fixed point in the past.
+*/
+long statsNow();
+
+/** This function reads the clock for timing something, if statistics are on.
+    @return the time in nanoseconds, or 0 if statistics are off.
+*/
+static inline long statsClock()
+{
+    return statsEnabled ? statsNow() : 0;
+}
+
+/** This function adds the time since start to a timer.
+    @param timer the timer.
+    @param start the time from statsClock() when it started, or 0 to record nothing.
+*/
+void recordTime( StatTimer timer, long start );
+
+/** This function adds one load of a course file to its statistics.
+    @param *filename pointer to the name of the course file.
+    @param courses the number of courses read from it.
+    @param *nanos array of the time spent on each phase.
+*/
+void recordLoad( char const *filename, long courses, long const nanos[ LOAD_PHASES ] );
+
+/** This function prints the statistics, along with how much memory a catalog uses.
+    @param *out pointer to the output to print to.
+    @param *catalog pointer to the catalog.
+*/
+void printStats( Output *out, Catalog const *catalog );
+
+#endif
@@ -0,0 +1,228 @@
+/** @file student.c
+    @author Huy Nguyen (hqnguyen)
+    This component contains functions for adding courses to and dropping courses from a
+    student's schedule, and for listing the schedule or printing it as a calendar.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "student.h"
+#include "input.h"
+
+void clearSchedule( Schedule *schedule ) 
+{
+    // With no bits set, none of the slots hold a course.
+    schedule->occupied = 0;
+    schedule->size = 0;
+}
+
+bool inSchedule( Schedule const *schedule, Course const *course ) 
+{
+    // The course is in the schedule if it is the course in its timeslot.
+    return (schedule->occupied & (1u << course->slot)) != 0 && schedule->slots[course->slot] == course;
+}
+
+bool addToSchedule( Schedule *schedule, Course *course ) 
+{
+    // If the schedule already contain 10 courses or the timeslot is used, it can't be added.
+    if (schedule->size >= SCHEDULE_MAX_LEN || (schedule->occupied & (1u << course->slot)) != 0) {
+        return false;
+    }
+    schedule->occupied |= 1u << course->slot;
+    schedule->slots[course->slot] = course;
+    schedule->size++;
+    return true;
+}
+
+bool dropFromSchedule( Schedule *schedule, Course const *course ) 
+{
+    if (!inSchedule(schedule, course)) {
+        return false;
+    }
+    // Clearing the bit frees the timeslot.
+    schedule->occupied &= ~(1u << course->slot);
+    schedule->size--;
+    return true;
+}
+
+int nextScheduled( Schedule const *schedule, int slot ) 
+{
+    // Skip over the free timeslots.
+    while (slot < TIMESLOT_COUNT && (schedule->occupied & (1u << slot)) == 0) {
+        slot++;
+    }
+    return slot < TIMESLOT_COUNT ? slot : -1;
+}
+
+void listSchedule( Output *out, Schedule const *schedule ) 
+{
+    // Print the header.
+    putText(out, LIST_HEADER);
+    // Timeslots are ordered by days followed by time, so print the courses in timeslot order.
+    for (int slot = nextScheduled(schedule, 0); slot >= 0; slot = nextScheduled(schedule, slot + 1)) {
+        Course const *course = schedule->slots[slot];
+        printCourse(out, course);
+    }  
+}
+
+void printCalendar( Output *out, Schedule const *schedule ) 
+{
+    // Time array to print, already padded to the width of the time column.
+    char* times[] = {" 8:30", "10:00", "11:30", " 1:00", " 2:30", " 4:00"};
+    // Print the header of the calendar.
+    putText(out, "         Mon      Tue      Wed      Thu\n");
+    
+    // Nested for loop. First loop through valid time to print them.
+    for (int i = 0; i < NUMBER_OF_VALID_TIME; i++) {
+        // Each line of the calendar is filled in and printed all at once.
+        char line[CALENDAR_LINE_LEN];
+        memcpy(line, times[i], TIME_LEN - 1);
+        char *cell = line + TIME_LEN - 1;
+        // Loop through each day, Mon and Wed are MW while Tue and Thu are TH.
+        for (int j = 0; j < CALENDAR_DAYS; j++) {
+            int slot = (j % NUMBER_OF_VALID_DAYS) * NUMBER_OF_VALID_TIME + i;
+            // If the timeslot has a course, the cell is the course id from its row.
+            cell[0] = ' ';
+            cell[1] = ' ';
+            if (schedule->occupied & (1u << slot)) {
+                memcpy(cell + 2, schedule->slots[slot]->row, ROW_ID_LEN);
+            }
+            // Otherwise there was not a match so the cell is a bunch of blank spaces.
+            else {
+                memset(cell + 2, ' ', ROW_ID_LEN);
+            }
+            cell += CALENDAR_CELL_LEN;
+        }
+        // New line character at the end.
+        *cell = '\n';
+        putBytes(out, line, CALENDAR_LINE_LEN);
+    }
+}
+
+SessionTable *makeSessions() 
+{
+    // Dynamically allocate memory for the table, its sessions and its pool of names.
+    SessionTable *table = (SessionTable *) malloc(sizeof(SessionTable));
+    table->count = 0;
+    table->capacity = SESSIONS_CAPACITY;
+    table->sessions = (Session *) malloc(table->capacity * sizeof(Session));
+    // Every slot of the index starts out empty.
+    table->index = (int32_t *) malloc(table->capacity * DOUBLE_ARRAY * sizeof(int32_t));
+    memset(table->index, -1, table->capacity * DOUBLE_ARRAY * sizeof(int32_t));
+    table->namesLen = 0;
+    table->namesCapacity = SESSIONS_CAPACITY * DOUBLE_ARRAY;
+    table->names = (char *) malloc(table->namesCapacity);
+    return table;
+}
+
+void freeSessions( SessionTable *table ) 
+{
+    free(table->sessions);
+    free(table->index);
+    free(table->names);
+    free(table);
+}
+
+/** Helper method to hash a student id into a slot of the session index.
+    @param *id pointer to the student id.
+    @param slots the number of slots in the index, a power of two.
+    @return the slot where the search for the student id should start.
+*/
+static int hashStudentId(char const *id, int slots) 
+{
+    // FNV-1a over the characters of the id.
+    uint32_t hash = 2166136261u;
+    for (int i = 0; id[i]; i++) {
+        hash = (hash ^ (unsigned char) id[i]) * 16777619u;
+    }
+    return hash & (slots - 1);
+}
+
+/** Helper method to add a session to the session index. The index must have at least one
+    empty slot.
+    @param *table pointer to the session table.
+    @param session the number of the session to add.
+*/
+static void indexSession(SessionTable *table, int session) 
+{
+    int slots = table->capacity * DOUBLE_ARRAY;
+    // Linear probing until an empty slot is found.
+    int slot = hashStudentId(table->names + table->sessions[session].nameOffset, slots);
+    while (table->index[slot] >= 0) {
+        slot = (slot + 1) & (slots - 1);
+    }
+    table->index[slot] = session;
+}
+
+int openSession( SessionTable *table, char const *id ) 
+{
+    // Probe from the home slot until the student or an empty slot is found.
+    int slots = table->capacity * DOUBLE_ARRAY;
+    int slot = hashStudentId(id, slots);
+    while (table->index[slot] >= 0) {
+        if (strcmp(table->names + table->sessions[table->index[slot]].nameOffset, id) == 0) {
+            return table->index[slot];
+        }
+        slot = (slot + 1) & (slots - 1);
+    }
+    
+    // Resizable array of sessions. The index is rebuilt twice as large along with it.
+    if (table->count >= table->capacity) {
+        table->capacity *= DOUBLE_ARRAY;
+        table->sessions = (Session *) realloc(table->sessions, table->capacity * sizeof(Session));
+        table->index = (int32_t *) realloc(table->index, table->capacity * DOUBLE_ARRAY * sizeof(int32_t));
+        memset(table->index, -1, table->capacity * DOUBLE_ARRAY * sizeof(int32_t));
+        for (int i = 0; i < table->count; i++) {
+            indexSession(table, i);
+        }
+    }
+    
+    // Resizable pool of names, with room for the id and its null character.
+    size_t len = strlen(id) + 1;
+    while (table->namesLen + len > table->namesCapacity) {
+        table->namesCapacity *= DOUBLE_ARRAY;
+        table->names = (char *) realloc(table->names, table->namesCapacity);
+    }
+    memcpy(table->names + table->namesLen, id, len);
+    
+    // The new session starts out with an empty schedule.
+    int session = table->count++;
+    table->sessions[session].nameOffset = table->namesLen;
+    table->namesLen += len;
+    clearSchedule(&table->sessions[session].schedule);
+    indexSession(table, session);
+    return session;
+}
+
+Schedule *sessionSchedule( SessionTable *table, int session ) 
+{
+    return &table->sessions[session].schedule;
+}
+
+void resolveSchedule( Schedule *schedule, Catalog const *catalog ) 
+{
+    // Take the courses out in timeslot order, then add back the new catalog's version of
+    // each one that is still offered.
+    Course *courses[TIMESLOT_COUNT];
+    int count = 0;
+    for (int slot = nextScheduled(schedule, 0); slot >= 0; slot = nextScheduled(schedule, slot + 1)) {
+        courses[count++] = schedule->slots[slot];
+    }
+    clearSchedule(schedule);
+    for (int i = 0; i < count; i++) {
+        Course *course = findCourseById(catalog, courses[i]->id);
+        if (course != NULL) {
+            addToSchedule(schedule, course);
+        }
+    }
+}
+
+void resolveSessions( SessionTable *table, Catalog const *catalog ) 
+{
+    for (int i = 0; i < table->count; i++) {
+        resolveSchedule(&table->sessions[i].schedule, catalog);
+    }
+}
@@ -0,0 +1,161 @@
+/** @file student.h
+    @author Huy Nguyen (hqnguyen)
+    This is the header file for the component that keeps track of a student's schedule and
+    prints it as a list or a calendar.
+*/
+#ifndef STUDENT_H
+#define STUDENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "catalog.h"
+
+/** There can only be 10 course in schedule max */
+#define SCHEDULE_MAX_LEN 10
+
+/** The days for calendar is Mon - Thur */
+#define CALENDAR_DAYS 4
+
+/** Width of one day's cell in the calendar, two spaces and a course id */
+#define CALENDAR_CELL_LEN (2 + ROW_ID_LEN)
+
+/** Length of a line of the calendar, the time, a cell for each day and a newline */
+#define CALENDAR_LINE_LEN (TIME_LEN - 1 + CALENDAR_DAYS * CALENDAR_CELL_LEN + 1)
+
+/** The schedule struct holds the courses a student has added. No two courses in a schedule
+    share a timeslot, so the courses are stored by timeslot: bit s of occupied is set when
+    timeslot s has a course in it, and slots[s] is that course. Size is the number of
+    courses in the schedule.
+*/
+typedef struct {
+    unsigned int occupied;
+    int size;
+    Course *slots[TIMESLOT_COUNT];
+    
+} Schedule;
+
+/** The initial number of sessions a session table has room for, must be a power of two */
+#define SESSIONS_CAPACITY 16
+
+/** The session struct is one student's schedule. The student's id is stored in the
+    session table's pool of names, starting at nameOffset.
+*/
+typedef struct {
+    uint32_t nameOffset;
+    Schedule schedule;
+    
+} Session;
+
+/** The session table struct keeps a schedule for each student, all sharing one catalog.
+    Sessions are stored next to each other in the sessions array, in the order they were
+    opened. The index field is an open addressing hash table from student id to a position
+    in the sessions array, -1 for an empty slot, with twice as many slots as the sessions
+    array has room for. The student ids are stored back to back in names, each followed
+    by a null character.
+*/
+typedef struct {
+    Session *sessions;
+    int count;
+    int capacity;
+    
+    int32_t *index;
+    
+    char *names;
+    size_t namesLen;
+    size_t namesCapacity;
+    
+} SessionTable;
+
+/** This function empty a schedule, so it has no courses.
+    @param *schedule pointer to the schedule.
+*/
+void clearSchedule( Schedule *schedule );
+
+/** This function check if a course is in a schedule.
+    @param *schedule pointer to the schedule.
+    @param *course pointer to the course.
+    @return true if the course is in the schedule and false otherwise.
+*/
+bool inSchedule( Schedule const *schedule, Course const *course );
+
+/** This function add a course to a schedule, if the schedule isn't full and the course's
+    timeslot is free. A course that is already in the schedule uses its own timeslot, so it
+    can't be added again.
+    @param *schedule pointer to the schedule.
+    @param *course pointer to the course.
+    @return true if the course was added and false otherwise.
+*/
+bool addToSchedule( Schedule *schedule, Course *course );
+
+/** This function drop a course from a schedule.
+    @param *schedule pointer to the schedule.
+    @param *course pointer to the course.
+    @return true if the course was dropped and false if it wasn't in the schedule.
+*/
+bool dropFromSchedule( Schedule *schedule, Course const *course );
+
+/** This function find the first timeslot at or after a given one that has a course in the
+    schedule. Looping from nextScheduled(schedule, 0) until it returns -1 visits the 
+    courses sorted by days followed by time.
+    @param *schedule pointer to the schedule.
+    @param slot the first timeslot to look at.
+    @return the timeslot, or -1 if there are no more courses.
+*/
+int nextScheduled( Schedule const *schedule, int slot );
+
+/** This function list all the courses in the student's schedule, sorted by days followed
+    by time.
+    @param *out where to print the courses.
+    @param *schedule pointer to the schedule.
+*/
+void listSchedule( Output *out, Schedule const *schedule );
+
+/** This function print the calendar based on the student's schedule.
+    @param *out where to print the calendar.
+    @param *schedule pointer to the schedule.
+*/
+void printCalendar( Output *out, Schedule const *schedule );
+
+/** This function dynamically allocate memory for a session table with no sessions.
+    @return a pointer to the new session table.
+*/
+SessionTable *makeSessions();
+
+/** This function free all the memory for the given session table.
+    @param *table pointer to the session table.
+*/
+void freeSessions( SessionTable *table );
+
+/** This function find the session for a student, opening a session with an empty schedule
+    if the student doesn't have one yet.
+    @param *table pointer to the session table.
+    @param *id pointer to the student's id.
+    @return the number of the student's session.
+*/
+int openSession( SessionTable *table, char const *id );
+
+/** This function get the schedule in a session. Opening another session can move the
+    schedules, so the pointer is only good until the next call to openSession().
+    @param *table pointer to the session table.
+    @param session the number of the session, from openSession().
+    @return a pointer to the session's schedule.
+*/
+Schedule *sessionSchedule( SessionTable *table, int session );
+
+/** This function points the courses in a schedule at a new version of the catalog, looking
+    each one up by its course id. A course that isn't in the new catalog is dropped, and
+    so is a course whose new timeslot is taken by a course before it in the schedule.
+    @param *schedule pointer to the schedule, whose courses must still be readable.
+    @param *catalog pointer to the new catalog.
+*/
+void resolveSchedule( Schedule *schedule, Catalog const *catalog );
+
+/** This function points the courses in every session's schedule at a new version of the
+    catalog, with resolveSchedule().
+    @param *table pointer to the session table.
+    @param *catalog pointer to the new catalog.
+*/
+void resolveSessions( SessionTable *table, Catalog const *catalog );
+
+#endif
@@ -109,6 +109,149 @@ if [ -x schedule ] ; then
     args=(courses-h.txt)
     runTest 20 1
  
+    args=(courses-b.txt courses-c.txt)
+    runTest 21 0
+ 
+    args=(courses-b.txt courses-c.txt)
+    runTest 22 0
+ 
+    args=(courses-b.txt)
+    runTest 23 0
+ 
+    args=(courses-b.txt courses-c.txt)
+    runTest 24 0
+ 
+    args=(courses-b.txt courses-c.txt)
+    runTest 25 0
+ 
+    args=(courses-b.txt courses-c.txt)
+    runTest 26 0
+ 
+    # Same files read with several loader threads.
+    args=(-j 3 courses-a.txt courses-b.txt courses-c.txt)
+    runTest 13 0
+ 
+    args=(-j 2 courses-a.txt file-that-doesnt-exist.txt)
+    runTest 16 1
+ 
+    args=(-j 2 courses-a.txt courses-g.txt)
+    runTest 19 1
+ 
+    # Batch mode prints the same transcript.
+    args=(--batch courses-b.txt courses-c.txt)
+    runTest 21 0
+ 
+    args=(--batch -j 2 courses-a.txt courses-g.txt)
+    runTest 19 1
+ 
+    # Same files compiled into a catalog image first.
+    ./schedule --compile-catalog catalog.bin courses-b.txt courses-c.txt
+    args=(catalog.bin)
+    runTest 14 0
+ 
+    # An image with a course count that doesn't match its arrays is read as a course file.
+    echo "Damaged image: catalog.bin with its course count changed"
+    printf '\377\377\0\0' | dd of=catalog.bin bs=1 seek=16 conv=notrunc 2> /dev/null
+    echo "list courses" | ./schedule catalog.bin > /dev/null 2> stderr.txt
+    if [ $? -eq 1 ] && grep -q "^Invalid course file: catalog.bin$" stderr.txt ; then
+        echo "PASS"
+    else
+        echo "**** FAILED - a damaged image wasn't turned away."
+        FAIL=1
+    fi
+    rm -f catalog.bin
+ 
+    # Same commands over a socket, all sent at once, then a short load test.
+    rm -f schedule.sock
+    ./schedule --serve schedule.sock courses-b.txt courses-c.txt &
+    SERVER=$!
+    for i in $(seq 50); do
+        ./loadgen schedule.sock -t 1 -c 1 -n 0 > /dev/null 2>&1 && break
+        sleep 0.1
+    done
+    echo "Test 21: ./loadgen schedule.sock -r input-21.txt > output.txt"
+    if ./loadgen schedule.sock -r input-21.txt > output.txt && diff -q expected-21.txt output.txt >/dev/null 2>&1 ; then
+        echo "PASS"
+    else
+        echo "**** FAILED - output over the socket didn't match expected."
+        FAIL=1
+    fi
+    echo "Load test: ./loadgen schedule.sock -t 2 -c 50 -n 500 -p 4 -i 100"
+    if ./loadgen schedule.sock -t 2 -c 50 -n 500 -p 4 -i 100 > /dev/null ; then
+        echo "PASS"
+    else
+        echo "**** FAILED - server didn't keep up with the load test."
+        FAIL=1
+    fi
+    echo "Test 22: ./loadgen schedule.sock -r input-22.txt > output.txt"
+    if ./loadgen schedule.sock -r input-22.txt > output.txt && diff -q expected-22.txt output.txt >/dev/null 2>&1 ; then
+        echo "PASS"
+    else
+        echo "**** FAILED - reload over the socket didn't match expected."
+        FAIL=1
+    fi
+ 
+    # A load that can't finish until a fifo is written doesn't hold up other clients,
+    # and its client hears back once it's done.
+    echo "Slow load: ./loadgen schedule.sock -r input-21.txt while another client loads a fifo"
+    rm -f slow.txt
+    mkfifo slow.txt
+    echo "load slow.txt" > slow-input.txt
+    ./loadgen schedule.sock -r slow-input.txt > stdout.txt &
+    LOADER=$!
+    sleep 0.2
+    timeout 5 ./loadgen schedule.sock -r input-21.txt > output.txt
+    STATUS=$?
+    # The fifo is swapped for a plain file once it's open, so a reload can read it too.
+    echo "ZZZ 999 MW 8:30 Slow Course" > slow-courses.txt
+    exec 3> slow.txt
+    mv slow-courses.txt slow.txt
+    cat slow.txt >&3
+    exec 3>&-
+    wait $LOADER
+    if [ $STATUS -eq 0 ] && diff -q expected-21.txt output.txt >/dev/null 2>&1 &&
+       [ "$(cat stdout.txt)" = "$(printf 'cmd> load slow.txt\n\ncmd> ')" ] ; then
+        echo "PASS"
+    else
+        echo "**** FAILED - a slow load held up another client or didn't answer."
+        FAIL=1
+    fi
+    kill $SERVER
+    wait $SERVER 2>/dev/null
+    rm -f schedule.sock slow.txt slow-input.txt
+ 
+    # Statistics print the commands and files they counted, and again at exit.
+    echo "Stats: ./schedule --stats courses-b.txt courses-c.txt < input-21.txt"
+    ./schedule --stats courses-b.txt courses-c.txt < input-21.txt > /dev/null 2> stderr.txt
+    if grep -q "^add  *5 " stderr.txt && grep -q "^courses-c.txt  *1  *15 " stderr.txt ; then
+        echo "PASS"
+    else
+        echo "**** FAILED - statistics didn't count the commands and files."
+        FAIL=1
+    fi
+ 
+    # A word longer than the command buffers is an invalid command, not copied.
+    echo "Long words: add followed by two 3000 letter words"
+    long=$(printf 'A%.0s' $(seq 3000))
+    if printf 'add %s %s\nquit\n' "$long" "$long" | ./schedule courses-b.txt > stdout.txt &&
+       grep -q "^Invalid command$" stdout.txt && grep -q "^cmd> quit" stdout.txt ; then
+        echo "PASS"
+    else
+        echo "**** FAILED - a long word wasn't turned away as an invalid command."
+        FAIL=1
+    fi
+ 
+    # Generated course files have to be valid, and their scripts run on them.
+    echo "Generated: ./coursegen -n 5000 -l 1-30 | ./schedule --batch ... < ./coursegen -n 5000 -l 1-30 -c 2000"
+    ./coursegen -n 5000 -l 1-30 > generated.txt
+    if ./coursegen -n 5000 -l 1-30 -c 2000 | ./schedule --batch generated.txt > /dev/null ; then
+        echo "PASS"
+    else
+        echo "**** FAILED - generated course file or script didn't run."
+        FAIL=1
+    fi
+    rm -f generated.txt
+ 
 else
     echo "**** Your program couldn't be tested since it didn't compile successfully."
     FAIL=1